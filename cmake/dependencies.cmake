@@ -24,6 +24,19 @@ FetchContent_Declare(
 )
 FetchContent_MakeAvailable(googletest)
 
+# Google Benchmark
+if(HBFT_BUILD_BENCHMARKS)
+    set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+    set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+    FetchContent_Declare(
+        benchmark
+        GIT_REPOSITORY https://github.com/google/benchmark.git
+        GIT_TAG v1.8.3
+        GIT_SHALLOW TRUE
+    )
+    FetchContent_MakeAvailable(benchmark)
+endif()
+
 # OpenSSL & Secp256k1
 find_package(OpenSSL REQUIRED COMPONENTS Crypto)
 find_package(PkgConfig REQUIRED)
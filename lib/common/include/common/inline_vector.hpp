@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <stdexcept>
+
+namespace Honey {
+
+/**
+ * @brief Vector with a compile-time capacity, stored inline.
+ *
+ * Never allocates; growing past `Capacity` throws std::length_error. Meant
+ * for short lists with a known bound, such as Merkle paths. Shared by
+ * core and crypto.
+ */
+template <typename T, std::size_t Capacity>
+class InlineVector {
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    InlineVector() = default;
+
+    InlineVector(std::initializer_list<T> init)
+    {
+        for (const T& value : init) {
+            push_back(value);
+        }
+    }
+
+    [[nodiscard]] static constexpr size_type capacity() noexcept { return Capacity; }
+    [[nodiscard]] size_type size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    [[nodiscard]] T* data() noexcept { return items_.data(); }
+    [[nodiscard]] const T* data() const noexcept { return items_.data(); }
+
+    [[nodiscard]] iterator begin() noexcept { return data(); }
+    [[nodiscard]] iterator end() noexcept { return data() + size_; }
+    [[nodiscard]] const_iterator begin() const noexcept { return data(); }
+    [[nodiscard]] const_iterator end() const noexcept { return data() + size_; }
+
+    [[nodiscard]] T& operator[](size_type i) noexcept { return items_[i]; }
+    [[nodiscard]] const T& operator[](size_type i) const noexcept { return items_[i]; }
+    [[nodiscard]] T& back() noexcept { return items_[size_ - 1]; }
+    [[nodiscard]] const T& back() const noexcept { return items_[size_ - 1]; }
+
+    void push_back(const T& value)
+    {
+        if (size_ == Capacity) {
+            throw std::length_error("InlineVector capacity exceeded");
+        }
+        items_[size_++] = value;
+    }
+    void pop_back() noexcept { --size_; }
+    void clear() noexcept { size_ = 0; }
+
+    friend bool operator==(const InlineVector& a, const InlineVector& b)
+    {
+        return std::ranges::equal(a, b);
+    }
+
+private:
+    std::array<T, Capacity> items_ {};
+    size_type size_ = 0;
+};
+
+} // namespace Honey
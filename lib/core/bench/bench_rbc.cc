@@ -0,0 +1,327 @@
+#include "core/rbc/hash_echo_broadcast.hpp"
+#include "core/rbc/rbc_mux.hpp"
+#include "core/rbc/reliable_broadcast.hpp"
+#include "utils_simple_task.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <bit>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <variant>
+#include <vector>
+
+namespace Honey::BFT::RBC {
+
+namespace {
+
+    struct NullTransport {
+        InlineTask<void> unicast(int /*target*/, const RBCMessage& /*msg*/) { co_return; }
+        InlineTask<void> broadcast(const RBCMessage& /*msg*/) { co_return; }
+    };
+
+    struct NullTree {
+        [[nodiscard]] Hash root() const { return {}; }
+    };
+
+    // 不做真实哈希，只按 SHA-256 压缩次数计数：叶子 1 次 + 路径上每层 1 次
+    struct HashCountingCrypto {
+        using MerkleTreeType = NullTree;
+        std::uint64_t hash_ops = 0;
+
+        InlineTask<NullTree> async_build_merkle_tree(int /*K*/, int /*N*/, BytesSpan /*data*/) { co_return NullTree {}; }
+
+        static ValPayload extract_val_payload(const NullTree& /*tree*/, int /*node_id*/) { return {}; }
+
+        InlineTask<bool> async_verify_merkle(BytesSpan /*stripe*/, size_t /*proof_index*/, std::span<const Hash> merkle_path, const Hash& /*root*/)
+        {
+            hash_ops += 1 + merkle_path.size();
+            co_return true;
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int /*K*/, int /*N*/, std::span<const ShardView> shards, const Hash& /*root*/)
+        {
+            co_return std::vector<Byte>(shards.front().data.begin(), shards.front().data.end());
+        }
+    };
+    static_assert(CryptoService<HashCountingCrypto>);
+
+    struct ReplayStream {
+        const std::vector<RBCMessage>* msgs;
+        size_t idx = 0;
+
+        InlineTask<std::optional<RBCMessage>> next()
+        {
+            if (idx >= msgs->size())
+                co_return std::nullopt;
+            co_return (*msgs)[idx++];
+        }
+    };
+
+    // 非 leader 节点视角：VAL，其余 N-1 个 ECHO，再 2f+1 个 READY
+    std::vector<RBCMessage> honest_instance(int N, int f, int me)
+    {
+        MerklePath path;
+        for (int i = 0; i < static_cast<int>(std::bit_width(static_cast<unsigned>(N - 1))); ++i) {
+            path.push_back(Hash {});
+        }
+        const SharedBytes stripe(std::vector<Byte>(64, std::byte { 1 }));
+
+        std::vector<RBCMessage> msgs;
+        msgs.push_back({ .sender = 0, .session_id = 0, .payload = ValPayload { .root_hash = {}, .proof_index = static_cast<size_t>(me), .merkle_path = path, .stripe = stripe } });
+        for (int i = 0; i < N; ++i) {
+            if (i != me)
+                msgs.push_back({ .sender = i, .session_id = 0, .payload = EchoPayload { .root_hash = {}, .proof_index = static_cast<size_t>(i), .merkle_path = path, .stripe = stripe } });
+        }
+        for (int i = 0; i <= 2 * f; ++i) {
+            msgs.push_back({ .sender = i, .session_id = 0, .payload = ReadyPayload { .root_hash = {} } });
+        }
+        return msgs;
+    }
+
+    void run_instances(benchmark::State& state, bool lazy)
+    {
+        const int N = static_cast<int>(state.range(0));
+        const int f = (N - 1) / 3;
+        const SystemContext ctx { .N = N, .f = f };
+        const auto msgs = honest_instance(N, f, 1);
+        NullTransport transport;
+        HashCountingCrypto crypto;
+
+        for (auto _ : state) {
+            ReliableBroadcast<NullTransport, HashCountingCrypto> rbc(ctx, 0, 1, 0, transport, crypto,
+                { .lazy_echo_verification = lazy });
+            auto task = rbc.run<InlineTask>(std::nullopt, ReplayStream { &msgs });
+            benchmark::DoNotOptimize(task.get());
+        }
+        state.counters["hash_ops"] = benchmark::Counter(
+            static_cast<double>(crypto.hash_ops), benchmark::Counter::kAvgIterations);
+    }
+
+    // ---- 全网模拟：N 个诚实节点在进程内互发消息 ----
+
+    constexpr double UPLINK_BYTES_PER_SEC = 100e6 / 8; // 每节点 100 Mbit/s 上行
+    constexpr double ONE_WAY_DELAY_SEC = 0.02;
+
+    // 消息的线上大小：sender + session_id + 类型标签，再加负载
+    std::uint64_t wire_size(const RBCMessage& msg)
+    {
+        constexpr std::uint64_t header = sizeof(NodeId) + sizeof(int) + 1;
+        const auto payload = [](const auto& p) -> std::uint64_t {
+            if constexpr (requires { p.stripe; })
+                return SHA256_BYTES + sizeof(std::uint64_t) + (p.merkle_path.size() * SHA256_BYTES) + p.stripe.size();
+            else
+                return SHA256_BYTES;
+        };
+        return header + std::visit(payload, msg.payload);
+    }
+
+    // 按到达时间投递；发送方上行链路串行发送，每条消息再加固定单程时延
+    struct Network {
+        struct InFlight {
+            double arrival;
+            std::uint64_t seq;
+            NodeId to;
+            RBCMessage msg;
+            bool operator>(const InFlight& o) const { return arrival != o.arrival ? arrival > o.arrival : seq > o.seq; }
+        };
+
+        explicit Network(int N)
+            : uplink_free(N, 0.0)
+        {
+            for (int i = 0; i < N; ++i) {
+                inboxes.push_back(std::make_shared<RBCChannel::Inbox>());
+            }
+        }
+
+        void send(NodeId from, NodeId to, const RBCMessage& msg)
+        {
+            double departure = now;
+            if (to != from) {
+                const std::uint64_t size = wire_size(msg);
+                bytes += size;
+                uplink_free[from] = std::max(uplink_free[from], now) + (static_cast<double>(size) / UPLINK_BYTES_PER_SEC);
+                departure = uplink_free[from] + ONE_WAY_DELAY_SEC;
+            }
+            queue.push({ departure, seq++, to, msg });
+        }
+
+        std::vector<std::shared_ptr<RBCChannel::Inbox>> inboxes;
+        std::vector<double> uplink_free;
+        std::priority_queue<InFlight, std::vector<InFlight>, std::greater<>> queue;
+        double now = 0;
+        std::uint64_t seq = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    // 以此字节开头的条带视为损坏：证明不通过，参与解码则失败
+    constexpr std::byte Poison { 0xEE };
+
+    struct SimTransport {
+        Network* net;
+        NodeId me;
+        bool poison_stripes = false; // 拜占庭节点：发出的 FRAGMENT 条带全部损坏
+
+        InlineTask<void> unicast(int target, const RBCMessage& msg)
+        {
+            send(target, msg);
+            co_return;
+        }
+        InlineTask<void> broadcast(const RBCMessage& msg)
+        {
+            for (int i = 0; i < static_cast<int>(net->inboxes.size()); ++i) {
+                if (i != me)
+                    send(i, msg);
+            }
+            co_return;
+        }
+
+        void send(int target, const RBCMessage& msg)
+        {
+            if (poison_stripes && std::holds_alternative<FragmentPayload>(msg.payload)) {
+                RBCMessage bad = msg;
+                auto& stripe = std::get<FragmentPayload>(bad.payload).stripe;
+                std::vector<Byte> bytes(stripe.begin(), stripe.end());
+                bytes.front() = Poison;
+                stripe = std::move(bytes);
+                net->send(me, target, bad);
+            } else {
+                net->send(me, target, msg);
+            }
+        }
+    };
+
+    struct SimTree {
+        std::vector<SharedBytes> stripes;
+        MerklePath path;
+    };
+
+    // 只切分不编码：条带长度与路径长度和真实 Merkle 树一致
+    struct SimCrypto {
+        using MerkleTreeType = SimTree;
+
+        InlineTask<SimTree> async_build_merkle_tree(int K, int N, BytesSpan data)
+        {
+            SimTree tree;
+            const std::size_t stripe = (data.size() + K - 1) / K;
+            for (int i = 0; i < N; ++i) {
+                tree.stripes.emplace_back(std::vector<Byte>(stripe, std::byte { 1 }));
+            }
+            for (int i = 0; i < static_cast<int>(std::bit_width(static_cast<unsigned>(N - 1))); ++i) {
+                tree.path.push_back(Hash {});
+            }
+            co_return tree;
+        }
+
+        static ValPayload extract_val_payload(const SimTree& tree, int node_id)
+        {
+            return ValPayload { .root_hash = {}, .proof_index = static_cast<size_t>(node_id), .merkle_path = tree.path, .stripe = tree.stripes[node_id] };
+        }
+
+        InlineTask<bool> async_verify_merkle(BytesSpan stripe, size_t /*proof_index*/, std::span<const Hash> /*merkle_path*/, const Hash& /*root*/)
+        {
+            co_return stripe.empty() || stripe.front() != Poison;
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int K, int /*N*/, std::span<const ShardView> shards, const Hash& /*root*/)
+        {
+            for (const ShardView& shard : shards) {
+                if (!shard.data.empty() && shard.data.front() == Poison)
+                    co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
+            co_return std::vector<Byte>(shards.front().data.size() * K);
+        }
+    };
+    static_assert(CryptoService<SimCrypto>);
+
+    // 一次广播：节点 0 发送 payload_bytes 字节，直到所有节点交付。
+    // faulty >= 0 时该节点发出的 FRAGMENT 条带全部损坏
+    template <typename Broadcast>
+    void simulate(benchmark::State& state, int faulty = -1)
+    {
+        const int N = static_cast<int>(state.range(0));
+        const auto payload_bytes = static_cast<std::size_t>(state.range(1));
+        const SystemContext ctx { .N = N, .f = (N - 1) / 3 };
+        SimCrypto crypto;
+        std::uint64_t bytes = 0;
+        double latency = 0;
+
+        for (auto _ : state) {
+            Network net(N);
+            std::vector<SimTransport> transports;
+            std::vector<std::unique_ptr<Broadcast>> nodes;
+            std::vector<InlineTask<RBCOutput>> tasks;
+            for (int i = 0; i < N; ++i) {
+                transports.push_back({ .net = &net, .me = i, .poison_stripes = i == faulty });
+            }
+            for (int i = 0; i < N; ++i) {
+                nodes.push_back(std::make_unique<Broadcast>(ctx, 0, i, 0, transports[i], crypto));
+                auto input = i == 0 ? std::optional(std::vector<Byte>(payload_bytes)) : std::nullopt;
+                tasks.push_back(nodes.back()->template run<InlineTask>(std::move(input), RBCChannel(net.inboxes[i])));
+            }
+
+            // 交付后继续应答 PROOF_REQUEST，直到实例退役
+            std::vector<InlineTask<void>> serving;
+            int delivered = 0;
+            while (!net.queue.empty()) {
+                auto msg = net.queue.top();
+                net.queue.pop();
+                net.now = msg.arrival;
+                const bool was_done = tasks[msg.to].done();
+                net.inboxes[msg.to]->push(std::move(msg.msg));
+                if (!was_done && tasks[msg.to].done()) {
+                    ++delivered;
+                    latency += net.now;
+                    if constexpr (requires { nodes[msg.to]->template serve<InlineTask>(RBCChannel(net.inboxes[msg.to])); })
+                        serving.push_back(nodes[msg.to]->template serve<InlineTask>(RBCChannel(net.inboxes[msg.to])));
+                }
+            }
+            for (const auto& inbox : net.inboxes) {
+                inbox->push(std::nullopt);
+            }
+            for (auto& task : tasks) {
+                benchmark::DoNotOptimize(task.get());
+            }
+            if (delivered != N)
+                state.SkipWithError("not every node delivered");
+            bytes += net.bytes;
+        }
+        state.counters["bytes_sent"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+        state.counters["latency_ms"] = benchmark::Counter(latency * 1e3 / N, benchmark::Counter::kAvgIterations);
+    }
+
+    void network_args(benchmark::internal::Benchmark* b)
+    {
+        for (int n : { 16, 32, 64, 128 }) {
+            for (int size : { 1 << 10, 1 << 20 }) {
+                b->Args({ n, size });
+            }
+        }
+    }
+
+} // namespace
+
+static void BM_DeliverEagerEcho(benchmark::State& state) { run_instances(state, false); }
+static void BM_DeliverLazyEcho(benchmark::State& state) { run_instances(state, true); }
+
+BENCHMARK(BM_DeliverEagerEcho)->Arg(4)->Arg(16)->Arg(64)->Arg(128);
+BENCHMARK(BM_DeliverLazyEcho)->Arg(4)->Arg(16)->Arg(64)->Arg(128);
+
+// 线上字节数与平均交付时延（模拟时钟），Bracha 式与 hash-echo 式对比
+static void BM_NetworkBracha(benchmark::State& state) { simulate<ReliableBroadcast<SimTransport, SimCrypto>>(state); }
+static void BM_NetworkHashEcho(benchmark::State& state) { simulate<HashEchoBroadcast<SimTransport, SimCrypto>>(state); }
+// 最后一个节点推送损坏条带：它推送到的 N-f-1 个节点都要走 PROOF_REQUEST
+static void BM_NetworkHashEchoOneBadPusher(benchmark::State& state)
+{
+    simulate<HashEchoBroadcast<SimTransport, SimCrypto>>(state, static_cast<int>(state.range(0)) - 1);
+}
+
+BENCHMARK(BM_NetworkBracha)->Apply(network_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_NetworkHashEcho)->Apply(network_args)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_NetworkHashEchoOneBadPusher)->Apply(network_args)->Unit(benchmark::kMillisecond);
+
+} // namespace Honey::BFT::RBC
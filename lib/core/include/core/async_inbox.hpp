@@ -0,0 +1,89 @@
+#pragma once
+
+#include <coroutine>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+namespace Honey::BFT {
+
+/**
+ * @brief Multi-producer, single-consumer queue a coroutine can await.
+ *
+ * `push` may be called from any thread. If the consumer is suspended in
+ * `next()`, the pushing thread resumes it inline, so results are consumed
+ * in the order they were pushed.
+ */
+template <typename T>
+class AsyncInbox {
+public:
+    void push(T value)
+    {
+        std::coroutine_handle<> waiter;
+        {
+            std::lock_guard lock(mutex_);
+            items_.push_back(std::move(value));
+            waiter = std::exchange(waiter_, {});
+        }
+        if (waiter) {
+            waiter.resume();
+        }
+    }
+
+    std::optional<T> try_pop()
+    {
+        std::lock_guard lock(mutex_);
+        return pop_locked();
+    }
+
+    /// Awaitable yielding the oldest item, suspending until there is one.
+    auto next()
+    {
+        struct Awaiter {
+            AsyncInbox& inbox;
+            std::optional<T> item;
+
+            bool await_ready()
+            {
+                item = inbox.try_pop();
+                return item.has_value();
+            }
+            bool await_suspend(std::coroutine_handle<> h)
+            {
+                std::lock_guard lock(inbox.mutex_);
+                // A push may have landed since await_ready
+                if ((item = inbox.pop_locked())) {
+                    return false;
+                }
+                inbox.waiter_ = h;
+                return true;
+            }
+            T await_resume()
+            {
+                if (!item) {
+                    item = inbox.try_pop();
+                }
+                return std::move(*item);
+            }
+        };
+        return Awaiter { *this, std::nullopt };
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<T> items_;
+    std::coroutine_handle<> waiter_;
+
+    std::optional<T> pop_locked()
+    {
+        if (items_.empty()) {
+            return std::nullopt;
+        }
+        T value = std::move(items_.front());
+        items_.pop_front();
+        return value;
+    }
+};
+
+} // namespace Honey::BFT
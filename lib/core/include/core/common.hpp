@@ -3,6 +3,9 @@
 namespace Honey::BFT {
 using NodeId = int;
 
+/// Largest cluster the fixed-capacity message fields are sized for.
+constexpr int MAX_NODES = 1024;
+
 struct SystemContext {
     int N; ///< Total number of nodes
     int f; ///< Maximum number of Byzantine faults tolerated
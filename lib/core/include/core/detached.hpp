@@ -0,0 +1,25 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+
+namespace Honey::BFT {
+
+/**
+ * @brief Fire-and-forget coroutine.
+ *
+ * Starts running as soon as it is called and frees its own frame when it
+ * finishes; nothing can await it. Exceptions must be handled inside, an
+ * escaping one terminates.
+ */
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept { }
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+} // namespace Honey::BFT
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/common.hpp"
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace Honey::BFT {
+
+/**
+ * @brief Set of node ids in [0, N) stored as a bitset.
+ *
+ * Sized once at construction; `insert`, `contains` and `count` never
+ * allocate. The count is kept alongside the bits so quorum checks are O(1).
+ */
+class NodeSet {
+public:
+    NodeSet() = default;
+
+    explicit NodeSet(int N)
+        : words_((static_cast<std::size_t>(N) + 63) / 64)
+        , capacity_(N)
+    {
+    }
+
+    [[nodiscard]] int capacity() const noexcept { return capacity_; }
+    [[nodiscard]] int count() const noexcept { return count_; }
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+
+    [[nodiscard]] bool contains(NodeId id) const noexcept
+    {
+        return in_range(id) && (words_[word(id)] & bit(id)) != 0;
+    }
+
+    /// Adds `id`; returns false if it was already present or out of range.
+    bool insert(NodeId id) noexcept
+    {
+        if (!in_range(id) || (words_[word(id)] & bit(id)) != 0) {
+            return false;
+        }
+        words_[word(id)] |= bit(id);
+        ++count_;
+        return true;
+    }
+
+    /// Removes `id`; returns false if it was not present.
+    bool erase(NodeId id) noexcept
+    {
+        if (!contains(id)) {
+            return false;
+        }
+        words_[word(id)] &= ~bit(id);
+        --count_;
+        return true;
+    }
+
+    /// Calls `fn(id)` for every member in ascending order.
+    template <typename Fn>
+    void for_each(Fn&& fn) const
+    {
+        for (std::size_t i = 0; i < words_.size(); ++i) {
+            for (std::uint64_t w = words_[i]; w != 0; w &= w - 1) {
+                fn(static_cast<NodeId>((i * 64) + static_cast<std::size_t>(std::countr_zero(w))));
+            }
+        }
+    }
+
+private:
+    std::vector<std::uint64_t> words_;
+    int capacity_ = 0;
+    int count_ = 0;
+
+    [[nodiscard]] bool in_range(NodeId id) const noexcept { return id >= 0 && id < capacity_; }
+    [[nodiscard]] static std::size_t word(NodeId id) noexcept { return static_cast<std::size_t>(id) / 64; }
+    [[nodiscard]] static std::uint64_t bit(NodeId id) noexcept { return std::uint64_t { 1 } << (id % 64); }
+};
+
+} // namespace Honey::BFT
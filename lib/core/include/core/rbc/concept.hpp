@@ -4,7 +4,7 @@
 #include "core/concepts.hpp"
 #include "core/rbc/messages.hpp"
 #include <expected>
-#include <map>
+#include <span>
 #include <system_error>
 
 namespace Honey::BFT::RBC {
@@ -13,6 +13,15 @@ using Byte = std::byte;
 using BytesSpan = std::span<const Byte>;
 using MutableBytesSpan = std::span<Byte>;
 
+/// A held stripe: the index it was proven at and a borrowed view of its bytes.
+struct ShardView {
+    int index;
+    BytesSpan data;
+};
+
+// Stripes inside RBCMessage are SharedBytes and paths are inline, so a
+// transport may copy the message once per recipient (into a send queue, say)
+// without allocating, and hand the stripe span straight to a gather write.
 template <typename T>
 concept Transceiver = requires(T& t, NodeId target, const RBCMessage& msg) {
     { t.unicast(target, msg) } -> Awaitable;
@@ -33,15 +42,20 @@ concept CanExtractPayload = requires(T& t, const typename T::MerkleTreeType& tre
 
 template <typename T>
 concept CanVerifyMerkleProof = requires(T& t,
-    BytesSpan stripe, size_t proof_index, std::vector<Hash> merkle_path, const Hash& root) {
+    BytesSpan stripe, size_t proof_index, std::span<const Hash> merkle_path, const Hash& root) {
     { t.async_verify_merkle(stripe, proof_index, merkle_path, root) } -> AwaitableOf<bool>;
 };
 
+// The views borrow from RBCCore and stay valid until the awaitable completes.
+// The decode must also re-encode the payload and fail unless the N shards
+// commit to `root` (Crypto::decode_and_recommit does both in one pass);
+// without that, a leader dispersing inconsistent shards could make honest
+// nodes deliver different payloads.
 template <typename T>
 concept CanDecodeShards = requires(T& t,
-    const std::map<int, std::vector<Byte>>& received_shards,
-    int K, int N) {
-    { t.async_decode(K, N, received_shards) } -> AwaitableOf<std::expected<std::vector<Byte>, std::error_code>>;
+    std::span<const ShardView> received_shards,
+    int K, int N, const Hash& root) {
+    { t.async_decode(K, N, received_shards, root) } -> AwaitableOf<std::expected<std::vector<Byte>, std::error_code>>;
 };
 
 template <typename T>
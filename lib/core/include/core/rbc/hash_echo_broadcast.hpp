@@ -0,0 +1,355 @@
+#pragma once
+
+#include "core/common.hpp"
+#include "core/concepts.hpp"
+#include "core/node_set.hpp"
+#include "core/rbc/concept.hpp"
+#include "core/rbc/messages.hpp"
+#include "core/rbc/rbc_core.hpp"
+#include "core/when_all.hpp"
+#include <algorithm>
+#include <expected>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Honey::BFT::RBC {
+
+/**
+ * @brief Reliable broadcast that votes with roots and pushes each stripe to
+ * N-f-1 peers.
+ *
+ * After Das, Xiang and Ren's RBC for long messages. The leader's VAL hands
+ * every node its stripe and Merkle proof. ECHO and READY then carry only the
+ * root. Just before its READY, a node pushes its stripe in a FRAGMENT to the
+ * N-f-1 nodes after it (mod N), without the proof: the decoder re-encodes
+ * and checks the root anyway. Each node so gets N-f-1 pushed stripes besides
+ * its own, f more than the N-2f it decodes from, and f silent peers cannot
+ * hold it up. ReliableBroadcast's ECHOs move N(N-1) stripes with proofs;
+ * this moves N(N-f-1) without, about a third less payload at N = 3f+1.
+ *
+ * A node broadcasts PROOF_REQUEST, and every peer answers with its stripe
+ * and proof, in two cases:
+ * - Decoding the unproven stripes failed, so one was bad. The node drops them
+ *   and from then on takes only stripes whose proofs check out.
+ * - It holds 2f+1 READYs and cannot reach N-2f stripes. A pushing peer whose
+ *   READY came without a stripe has none; f of those yet to send READY may
+ *   be faulty.
+ * Either way that node costs as much as under ReliableBroadcast. This is the
+ * price of unproven pushes: one faulty node can push a bad stripe to all N-f-1
+ * nodes after it and send each of them down this path.
+ *
+ * A push goes out before the READY on the same link, so the transport should
+ * keep each peer's messages in order, as TCP does; reordering only makes a
+ * node ask for proofs it did not need.
+ *
+ * run() stops reading at delivery, yet a slower node may ask for our proof
+ * after that. The embedder should run serve() on the rest of the instance's
+ * stream until it retires the instance (an RBCMux channel ends then);
+ * otherwise a node that asks late may never deliver.
+ *
+ * Same concepts and run() as ReliableBroadcast, so either can be swapped in.
+ */
+template <Transceiver T, CryptoService C>
+class HashEchoBroadcast {
+private:
+    const SystemContext& system_ctx_;
+    int sid_;
+    NodeId my_pid_, leader_;
+    T& transport_;
+    C& crypto_;
+    RBCCore core_;
+
+    std::optional<FragmentPayload> own_; ///< our stripe and its proof, from the VAL
+    std::optional<Hash> ready_root_; ///< the root our READY named
+    bool pushed_ = false; ///< our stripe went to the peers after us
+    bool proofs_only_ = false; ///< an unproven decode failed
+    int failed_decode_shards_ = 0; ///< proven stripes held when a decode of them last failed
+    bool proofs_requested_ = false;
+    NodeSet proof_requests_; ///< peers that asked for our proof
+    NodeSet answered_; ///< peers we sent it to
+
+    using Tree = typename C::MerkleTreeType;
+
+public:
+    HashEchoBroadcast(
+        const SystemContext& system_ctx,
+        int sid,
+        NodeId my_pid,
+        NodeId leader,
+        T& transport,
+        C& crypto)
+        : system_ctx_(system_ctx)
+        , sid_(sid)
+        , my_pid_(my_pid)
+        , leader_(leader)
+        , transport_(transport)
+        , crypto_(crypto)
+        , core_({ .session_id = sid, .node_id = my_pid, .total_nodes = system_ctx.N, .fault_tolerance = system_ctx.f, .leader_id = leader })
+        , proof_requests_(system_ctx.N)
+        , answered_(system_ctx.N)
+    {
+    }
+
+    template <template <typename> typename TaskT, AsyncStreamOf<RBCMessage> Stream>
+    auto run(std::optional<std::vector<Byte>> input, Stream stream) -> TaskT<RBCOutput>
+    {
+        co_await disperse<TaskT>(std::move(input));
+
+        while (auto msg_opt = co_await stream.next()) {
+            RBCMessage msg = std::move(*msg_opt);
+
+            if (!is_filed_correctly(msg))
+                continue;
+            const bool proven = needs_proof(msg);
+            if (proven && !co_await verify(msg))
+                continue;
+            apply(std::move(msg), proven);
+
+            if (auto output = co_await react<TaskT>())
+                co_return std::move(*output);
+        }
+
+        throw std::runtime_error("RBC terminated without delivering output");
+    }
+
+    /// Answers PROOF_REQUESTs from `stream` until it ends, once per peer;
+    /// other messages are dropped. For after run() has delivered.
+    template <template <typename> typename TaskT, AsyncStreamOf<RBCMessage> Stream>
+    auto serve(Stream stream) -> TaskT<void>
+    {
+        while (auto msg = co_await stream.next()) {
+            if (std::holds_alternative<ProofRequestPayload>(msg->payload))
+                proof_requests_.insert(msg->sender);
+            co_await answer_proof_requests<TaskT>();
+        }
+    }
+
+private:
+    [[nodiscard]] int data_shards() const { return system_ctx_.N - (2 * system_ctx_.f); }
+    /// Peers a node pushes its stripe to: the N-f-1 after it, mod N.
+    [[nodiscard]] int push_fanout() const { return system_ctx_.N - system_ctx_.f - 1; }
+
+    // The leader encodes its input and sends every node its VAL.
+    template <template <typename> typename TaskT>
+    auto disperse(std::optional<std::vector<Byte>> input) -> TaskT<void>
+    {
+        if (core_.is_leader(my_pid_) && input) {
+            Tree tree = co_await crypto_.async_build_merkle_tree(
+                data_shards(),
+                system_ctx_.N,
+                BytesSpan { *input });
+
+            std::vector<RBCMessage> vals;
+            vals.reserve(system_ctx_.N);
+            for (int i = 0; i < system_ctx_.N; ++i) {
+                vals.push_back(RBCMessage {
+                    .sender = my_pid_,
+                    .session_id = sid_,
+                    .payload = crypto_.extract_val_payload(tree, i) });
+            }
+            using Send = decltype(transport_.unicast(NodeId {}, vals.front()));
+            std::vector<Send> sends;
+            sends.reserve(vals.size());
+            for (int i = 0; i < system_ctx_.N; ++i) {
+                sends.push_back(transport_.unicast(i, vals[i]));
+            }
+            co_await when_all(std::move(sends));
+        }
+    }
+
+    // A FRAGMENT's stripe is stored under its sender, so its proof must be
+    // for the sender's leaf; otherwise a peer could pass off another's.
+    bool is_filed_correctly(const RBCMessage& msg) const
+    {
+        const auto* p = std::get_if<FragmentPayload>(&msg.payload);
+        return p == nullptr || p->proof_index == static_cast<size_t>(msg.sender);
+    }
+
+    // VALs are always checked, and FRAGMENTs that carry a proof. Once an
+    // unproven decode failed, a FRAGMENT without a valid proof is dropped.
+    bool needs_proof(const RBCMessage& msg) const
+    {
+        if (const auto* p = std::get_if<FragmentPayload>(&msg.payload))
+            return proofs_only_ || !p->merkle_path.empty();
+        return std::holds_alternative<ValPayload>(msg.payload);
+    }
+
+    auto verify(const RBCMessage& msg)
+    {
+        if (const auto* p = std::get_if<ValPayload>(&msg.payload))
+            return crypto_.async_verify_merkle(p->stripe, p->proof_index, p->merkle_path, p->root_hash);
+        const auto& p = std::get<FragmentPayload>(msg.payload);
+        return crypto_.async_verify_merkle(p.stripe, p.proof_index, p.merkle_path, p.root_hash);
+    }
+
+    void apply(RBCMessage&& msg, bool proven)
+    {
+        if (auto* p = std::get_if<ValPayload>(&msg.payload)) {
+            if (!core_.is_valid_val(msg.sender, *p))
+                return;
+            if (!own_)
+                own_ = FragmentPayload { .root_hash = p->root_hash, .proof_index = p->proof_index, .merkle_path = p->merkle_path, .stripe = p->stripe };
+            core_.observe_val(msg.sender, std::move(*p));
+        } else if (auto* p = std::get_if<EchoHashPayload>(&msg.payload)) {
+            core_.observe_echo_vote(msg.sender, p->root_hash);
+        } else if (auto* p = std::get_if<ReadyPayload>(&msg.payload)) {
+            core_.observe_ready(msg.sender, *p);
+        } else if (auto* p = std::get_if<FragmentPayload>(&msg.payload)) {
+            // Our own stripe came with the VAL
+            if (msg.sender != my_pid_)
+                core_.observe_stripe(msg.sender, p->root_hash, std::move(p->stripe), proven);
+        } else if (std::holds_alternative<ProofRequestPayload>(msg.payload)) {
+            proof_requests_.insert(msg.sender);
+        }
+    }
+
+    // Sends ECHO and READY as the core's state calls for them, pushing our
+    // stripe ahead of the READY, and our proof to whoever asked for it.
+    template <template <typename> typename TaskT>
+    auto announce() -> TaskT<void>
+    {
+        if (core_.has_received_val() && !core_.has_sent_echo()) {
+            co_await transport_.broadcast(construct_vote<EchoHashPayload>(core_.get_current_root()));
+            core_.mark_echo_sent();
+        }
+        if (!core_.has_sent_ready()) {
+            if (core_.should_send_ready())
+                ready_root_ = core_.get_current_root();
+            else if (!core_.has_received_val())
+                ready_root_ = core_.ready_backed_root();
+            if (ready_root_) {
+                if (own_ && own_->root_hash == *ready_root_)
+                    co_await push_stripe<TaskT>(false);
+                // mark_ready_sent() alone would only count it for the VAL's root
+                core_.observe_ready(my_pid_, ReadyPayload { .root_hash = *ready_root_ });
+                co_await transport_.broadcast(construct_vote<ReadyPayload>(*ready_root_));
+                core_.mark_ready_sent();
+            }
+        }
+        // The VAL came after our READY, and peers took us for having no
+        // stripe: they may be asking for proofs already
+        if (own_ && !pushed_ && ready_root_ == own_->root_hash)
+            co_await push_stripe<TaskT>(true);
+
+        co_await answer_proof_requests<TaskT>();
+    }
+
+    template <template <typename> typename TaskT>
+    auto push_stripe(bool with_proof) -> TaskT<void>
+    {
+        pushed_ = true;
+        const RBCMessage fragment = construct_fragment(with_proof);
+        using Send = decltype(transport_.unicast(NodeId {}, fragment));
+        std::vector<Send> sends;
+        sends.reserve(push_fanout());
+        for (int i = 1; i <= push_fanout(); ++i) {
+            sends.push_back(transport_.unicast((my_pid_ + i) % system_ctx_.N, fragment));
+        }
+        co_await when_all(std::move(sends));
+    }
+
+    template <template <typename> typename TaskT>
+    auto answer_proof_requests() -> TaskT<void>
+    {
+        if (!own_ || proof_requests_.count() == answered_.count())
+            co_return;
+        std::vector<NodeId> pending;
+        proof_requests_.for_each([&](NodeId id) {
+            if (!answered_.contains(id))
+                pending.push_back(id);
+        });
+        const RBCMessage proof = construct_fragment(true);
+        for (NodeId id : pending) {
+            answered_.insert(id);
+            co_await transport_.unicast(id, proof);
+        }
+    }
+
+    // With 2f+1 READYs, whether the stripes held and those still to be
+    // pushed to us fall short of N-2f. A pusher whose READY came without a
+    // stripe has none, and f of those yet to send READY may never do so.
+    bool starved() const
+    {
+        const Hash root = core_.get_current_root();
+        if (core_.count_ready(root) < (2 * system_ctx_.f) + 1)
+            return false;
+        const int held = core_.count_shards(root) + core_.count_unverified(root);
+        int silent = 0;
+        for (int i = 1; i <= push_fanout(); ++i) {
+            const NodeId pusher = (my_pid_ - i + system_ctx_.N) % system_ctx_.N;
+            if (!core_.has_stripe(pusher) && !core_.has_ready_from(pusher))
+                ++silent;
+        }
+        return held + std::max(0, silent - system_ctx_.f) < data_shards();
+    }
+
+    // Yields the output once it can be delivered. The first decode takes
+    // every stripe held, proven or not; if it fails, only proven ones count,
+    // and a failed decode of those is retried once more have arrived.
+    template <template <typename> typename TaskT>
+    auto react() -> TaskT<std::optional<RBCOutput>>
+    {
+        co_await announce<TaskT>();
+        if (!core_.has_received_val())
+            co_return std::nullopt;
+
+        if (!proofs_only_ && core_.could_output()) {
+            auto result = co_await decode<TaskT>(core_.get_candidate_shards());
+            if (result)
+                co_return std::move(*result);
+            core_.reject_unverified();
+            proofs_only_ = true;
+        }
+        if (!proofs_requested_ && (proofs_only_ || starved())) {
+            proofs_requested_ = true;
+            co_await transport_.broadcast(construct_vote<ProofRequestPayload>(core_.get_current_root()));
+        }
+
+        const int proven = core_.count_shards(core_.get_current_root());
+        if (proofs_only_ && core_.can_output() && proven > failed_decode_shards_) {
+            auto result = co_await decode<TaskT>(core_.get_shards());
+            if (result)
+                co_return std::move(*result);
+            failed_decode_shards_ = proven;
+        }
+        co_return std::nullopt;
+    }
+
+    template <template <typename> typename TaskT>
+    auto decode(std::vector<ShardView> shards) -> TaskT<std::expected<RBCOutput, std::error_code>>
+    {
+        co_return co_await crypto_.async_decode(
+            data_shards(),
+            system_ctx_.N,
+            std::span<const ShardView> { shards },
+            core_.get_current_root());
+    }
+
+    template <typename Payload>
+    RBCMessage construct_vote(const Hash& root)
+    {
+        return RBCMessage {
+            .sender = my_pid_,
+            .session_id = sid_,
+            .payload = Payload { .root_hash = root }
+        };
+    }
+    RBCMessage construct_fragment(bool with_proof)
+    {
+        FragmentPayload fragment = *own_;
+        if (!with_proof)
+            fragment.merkle_path.clear();
+        return RBCMessage {
+            .sender = my_pid_,
+            .session_id = sid_,
+            .payload = std::move(fragment)
+        };
+    }
+};
+
+} // namespace Honey::BFT::RBC
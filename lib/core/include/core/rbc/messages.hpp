@@ -1,7 +1,10 @@
 #pragma once
 
 #include "core/common.hpp"
+#include "common/inline_vector.hpp"
+#include "core/shared_buffer.hpp"
 #include <array>
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <variant>
@@ -13,25 +16,54 @@ constexpr std::int8_t SHA256_BYTES = 32;
 using SHA256Hash = std::array<std::byte, SHA256_BYTES>;
 using Hash = SHA256Hash;
 
+/// Siblings on a binary Merkle path over at most MAX_NODES leaves.
+constexpr std::size_t MAX_MERKLE_PATH = std::bit_width(static_cast<std::size_t>(MAX_NODES) - 1);
+/// Merkle path stored inline, so a VAL/ECHO allocates nothing besides its stripe.
+using MerklePath = InlineVector<Hash, MAX_MERKLE_PATH>;
+
+// Stripes are shared, immutable buffers: copying a message, e.g. once per
+// peer on broadcast, never copies their bytes.
+
 struct ValPayload {
     Hash root_hash;
     size_t proof_index;
-    std::vector<Hash> merkle_path;
-    std::vector<std::byte> stripe;
+    MerklePath merkle_path;
+    SharedBytes stripe;
 };
 
 struct EchoPayload {
     Hash root_hash;
     size_t proof_index;
-    std::vector<Hash> merkle_path;
-    std::vector<std::byte> stripe;
+    MerklePath merkle_path;
+    SharedBytes stripe;
 };
 
 struct ReadyPayload {
     Hash root_hash;
 };
 
-using RBCPayload = std::variant<ValPayload, EchoPayload, ReadyPayload>;
+// The hash-echo variant (HashEchoBroadcast) votes with roots alone and
+// pushes stripes to a subset of peers in FRAGMENTs instead.
+
+struct EchoHashPayload {
+    Hash root_hash;
+};
+
+/// A node's own stripe. The Merkle path is empty in a push, and present in
+/// an answer to a PROOF_REQUEST.
+struct FragmentPayload {
+    Hash root_hash;
+    size_t proof_index;
+    MerklePath merkle_path;
+    SharedBytes stripe;
+};
+
+struct ProofRequestPayload {
+    Hash root_hash;
+};
+
+using RBCPayload = std::variant<ValPayload, EchoPayload, ReadyPayload,
+    EchoHashPayload, FragmentPayload, ProofRequestPayload>;
 
 struct RBCMessage {
     NodeId sender {};
@@ -1,11 +1,12 @@
 #pragma once
 
+#include "core/node_set.hpp"
 #include "core/rbc/concept.hpp"
 #include "core/rbc/messages.hpp"
-#include <map>
+#include <algorithm>
 #include <optional>
-#include <set>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace Honey::BFT::RBC {
@@ -18,6 +19,27 @@ struct RBCConfig {
     int leader_id;
 };
 
+/**
+ * @brief Pure state machine of one Bracha RBC instance.
+ *
+ * State is kept per candidate root in a small flat table. Each slot holds
+ * NodeId-indexed stripes and NodeSet bitsets of ECHO and READY senders.
+ * Only a sender's first ECHO and first READY are counted, for whichever
+ * root they name. The threshold checks read counters of the current root's
+ * slot and never allocate.
+ *
+ * Stripes are kept as the SharedBytes they arrived in and handed to the
+ * decoder as borrowed views, so a delivered instance copies no stripe bytes.
+ *
+ * An ECHO may also be observed before its Merkle proof is checked. It
+ * counts as a vote at once, since the vote does not depend on the stripe,
+ * but its stripe is set aside until the caller verifies it and calls
+ * accept_echo or reject_echo. Only accepted stripes reach the decoder.
+ *
+ * HashEchoBroadcast drives the same thresholds with ECHOs that carry no
+ * stripe (observe_echo_vote) and stripes that arrive on their own
+ * (observe_stripe), possibly without any proof to check them by.
+ */
 class RBCCore {
 public:
     explicit RBCCore(const RBCConfig& config)
@@ -26,7 +48,13 @@ public:
         , N_(config.total_nodes)
         , f_(config.fault_tolerance)
         , leader_(config.leader_id)
+        , echoed_(config.total_nodes)
+        , readied_(config.total_nodes)
+        , stripe_senders_(config.total_nodes)
     {
+        if (config.total_nodes > MAX_NODES) {
+            throw std::invalid_argument("RBCCore: total_nodes exceeds MAX_NODES");
+        }
     }
 
     [[nodiscard]] bool is_leader(NodeId pid) const { return pid == leader_; }
@@ -38,90 +66,265 @@ public:
             return false;
         if (current_root_ && *current_root_ != p.root_hash)
             return false;
-        return true;
+        // Its proof must be for our own leaf, where the stripe is stored
+        return p.proof_index == static_cast<size_t>(pid_);
     }
+    /// An ECHO's proof must be for its sender's leaf: the stripe is stored
+    /// under the sender, so a peer replaying another's ECHO, valid proof and
+    /// all, would otherwise put the wrong stripe at its own index.
     [[nodiscard]] bool is_valid_echo(int sender, const EchoPayload& p) const
     {
-        // 验证 Echo 消息的合法性 (如有需要)
-        return true; // 占位实现
+        return sender >= 0 && p.proof_index == static_cast<size_t>(sender);
     }
 
-    void observe_val(int sender, const ValPayload& p)
+    void observe_val(int sender, ValPayload&& p)
     {
         // 处理 Val 消息，更新状态
         if (!current_root_) {
             current_root_ = p.root_hash;
         }
+        // The VAL's root always gets a slot, evicting a candidate if need be.
+        if (find_slot_index(p.root_hash) < 0 && slots_.size() >= max_slots()) {
+            evict_weakest();
+        }
+        RootSlot* slot = slot_for(p.root_hash);
+        if (current_slot_ < 0) {
+            current_slot_ = find_slot_index(p.root_hash);
+        }
         // The VAL stripe is targeted for this node, so store it under our own id.
-        stripes_[p.root_hash][pid_] = p.stripe;
+        store_stripe(*slot, pid_, std::move(p.stripe));
+    }
+    void observe_echo(int sender, EchoPayload&& p)
+    {
+        // 处理 Echo 消息，更新状态；每个节点只有第一条 ECHO 计票
+        if (!is_valid_echo(sender, p))
+            return;
+        RootSlot* slot = first_vote_slot(echoed_, sender, p.root_hash);
+        if (slot == nullptr)
+            return;
+        slot->echoes.insert(sender);
+        store_stripe(*slot, sender, std::move(p.stripe));
     }
-    void observe_echo(int sender, const EchoPayload& p)
+    /// Like observe_echo, but the stripe waits for accept_echo/reject_echo.
+    void observe_unverified_echo(int sender, EchoPayload&& p)
     {
-        // 处理 Echo 消息，更新状态
-        echo_senders_[p.root_hash].insert(sender);
-        stripes_[p.root_hash][sender] = p.stripe;
+        if (!is_valid_echo(sender, p))
+            return;
+        RootSlot* slot = first_vote_slot(echoed_, sender, p.root_hash);
+        if (slot == nullptr)
+            return;
+        slot->echoes.insert(sender);
+        if (slot->proofs.empty()) {
+            slot->proofs.resize(N_);
+        }
+        slot->proofs[sender] = { .proof_index = p.proof_index, .merkle_path = p.merkle_path };
+        slot->stripes[sender] = std::move(p.stripe);
+        slot->unverified.insert(sender);
+    }
+    /// Counts an ECHO that names a root but carries no stripe.
+    void observe_echo_vote(int sender, const Hash& root)
+    {
+        if (RootSlot* slot = first_vote_slot(echoed_, sender, root))
+            slot->echoes.insert(sender);
+    }
+    /// Stores a stripe `sender` sent outside an ECHO. Without `verified` it
+    /// waits with the unverified ECHO stripes, but has no proof to be checked
+    /// by: only the decoder's root check can vouch for it. A verified stripe
+    /// is never replaced by an unverified one.
+    ///
+    /// Stripes never create a slot. One is kept only for the current root or
+    /// the root `sender` echoed, and only a sender's first unverified stripe
+    /// is taken, so a faulty sender holds at most one stripe per slot.
+    void observe_stripe(int sender, const Hash& root, SharedBytes&& stripe, bool verified)
+    {
+        if (sender < 0 || sender >= N_)
+            return;
+        const int i = find_slot_index(root);
+        if (i < 0 || (i != current_slot_ && !slots_[i].echoes.contains(sender)))
+            return;
+        RootSlot& slot = slots_[i];
+        if (verified) {
+            store_stripe(slot, sender, std::move(stripe));
+            return;
+        }
+        if (slot.held.contains(sender) || !stripe_senders_.insert(sender))
+            return;
+        if (slot.proofs.empty()) {
+            slot.proofs.resize(N_);
+        }
+        slot.proofs[sender] = {};
+        slot.stripes[sender] = std::move(stripe);
+        slot.unverified.insert(sender);
     }
     void observe_ready(int sender, const ReadyPayload& p)
     {
-        // 处理 Ready 消息，更新状态
-        ready_senders_[p.root_hash].insert(sender);
+        // 处理 Ready 消息，更新状态；每个节点只有第一条 READY 计票
+        if (RootSlot* slot = first_vote_slot(readied_, sender, p.root_hash))
+            slot->readies.insert(sender);
     }
 
     bool has_received_val() const { return current_root_.has_value(); }
+    /// Roots with a slot; never more than max_slots().
+    std::size_t candidate_roots() const { return slots_.size(); }
+    /// f faulty senders name at most 2f roots between their first ECHO and
+    /// first READY, so with 2f+1 slots an honest leader's root always finds
+    /// one.
+    std::size_t max_slots() const { return static_cast<std::size_t>((2 * f_) + 1); }
     bool has_sent_echo() const { return echo_sent_; }
     bool has_sent_ready() const { return ready_sent_; }
 
     auto count_echo(const Hash& root) const -> int
     {
-        auto it = echo_senders_.find(root);
-        if (it != echo_senders_.end()) {
-            return static_cast<int>(it->second.size());
-        }
-        return 0;
+        const RootSlot* slot = find_slot(root);
+        return slot ? slot->echoes.count() : 0;
     }
     auto count_ready(const Hash& root) const -> int
     {
-        auto it = ready_senders_.find(root);
-        if (it != ready_senders_.end()) {
-            return static_cast<int>(it->second.size());
-        }
-        return 0;
+        const RootSlot* slot = find_slot(root);
+        return slot ? slot->readies.count() : 0;
     }
     auto count_shards(const Hash& root) const -> int
     {
-        auto it = stripes_.find(root);
-        if (it != stripes_.end()) {
-            return static_cast<int>(it->second.size());
+        const RootSlot* slot = find_slot(root);
+        return slot ? slot->held.count() : 0;
+    }
+    auto count_unverified(const Hash& root) const -> int
+    {
+        const RootSlot* slot = find_slot(root);
+        return slot ? slot->unverified.count() : 0;
+    }
+    /// A stripe from `id` for the current root is held or awaits its check.
+    bool has_stripe(NodeId id) const
+    {
+        const RootSlot& slot = current_slot();
+        return slot.held.contains(id) || slot.unverified.contains(id);
+    }
+    /// `id`'s READY was counted, for any root.
+    bool has_ready_from(NodeId id) const { return readied_.contains(id); }
+    /// A root named by f+1 READYs, so by at least one honest node. Bracha's
+    /// amplification lets a node the VAL has not reached send READY for it.
+    std::optional<Hash> ready_backed_root() const
+    {
+        for (const RootSlot& slot : slots_) {
+            if (slot.readies.count() >= f_ + 1)
+                return slot.root;
         }
-        return 0;
+        return std::nullopt;
     }
+
     // 核心算法阈值判断
     bool should_send_ready() const
     {
         // Algorithm: N-f ECHO or f+1 READY
-        if (!current_root_)
+        if (current_slot_ < 0)
             return false;
-        auto root = *current_root_;
-        return (count_echo(root) >= N_ - f_) || (count_ready(root) >= f_ + 1);
+        const RootSlot& slot = slots_[current_slot_];
+        return (slot.echoes.count() >= N_ - f_) || (slot.readies.count() >= f_ + 1);
     }
 
     bool can_output() const
     {
         // Algorithm: 2f+1 READY and N-2f Shards
-        if (!current_root_)
+        if (current_slot_ < 0)
+            return false;
+        const RootSlot& slot = slots_[current_slot_];
+        return (slot.readies.count() >= (2 * f_) + 1) && (slot.held.count() >= N_ - 2 * f_);
+    }
+
+    /// can_output() would hold if enough unverified stripes check out.
+    bool could_output() const
+    {
+        if (current_slot_ < 0)
+            return false;
+        const RootSlot& slot = slots_[current_slot_];
+        return (slot.readies.count() >= (2 * f_) + 1)
+            && (slot.held.count() + slot.unverified.count() >= N_ - 2 * f_);
+    }
+    /// Held and unverified stripes of the current root would be enough to
+    /// decode, whatever the READY count.
+    bool could_decode() const
+    {
+        if (current_slot_ < 0)
             return false;
-        auto root = *current_root_;
-        return (count_ready(root) >= (2 * f_) + 1) && (count_shards(root) >= N_ - 2 * f_);
+        const RootSlot& slot = slots_[current_slot_];
+        return slot.held.count() + slot.unverified.count() >= N_ - (2 * f_);
+    }
+    /// Verified stripes the current root still lacks for can_output().
+    int missing_shards() const
+    {
+        return std::max(0, N_ - (2 * f_) - current_slot().held.count());
+    }
+
+    /// An ECHO stripe for the current root awaiting its Merkle check.
+    struct UnverifiedEcho {
+        NodeId sender;
+        size_t proof_index;
+        const MerklePath& merkle_path;
+        const SharedBytes& stripe;
+    };
+    /// Unverified ECHOs for the current root in ascending sender order, so
+    /// data shards come first; valid until the next observe_* call.
+    std::vector<UnverifiedEcho> unverified_echoes() const
+    {
+        const RootSlot& slot = current_slot();
+        std::vector<UnverifiedEcho> echoes;
+        echoes.reserve(static_cast<std::size_t>(slot.unverified.count()));
+        slot.unverified.for_each([&](NodeId id) {
+            echoes.push_back({ .sender = id, .proof_index = slot.proofs[id].proof_index, .merkle_path = slot.proofs[id].merkle_path, .stripe = slot.stripes[id] });
+        });
+        return echoes;
+    }
+    /// The stripe `sender` echoed for the current root passed its check.
+    void accept_echo(NodeId sender)
+    {
+        RootSlot& slot = slots_.at(current_slot_);
+        if (slot.unverified.erase(sender))
+            slot.held.insert(sender);
+    }
+    /// It failed: drop the stripe. The vote stays, as it would for any
+    /// first ECHO from that sender.
+    void reject_echo(NodeId sender)
+    {
+        RootSlot& slot = slots_.at(current_slot_);
+        if (slot.unverified.erase(sender))
+            slot.stripes[sender] = {};
+    }
+
+    /// Drops every unverified stripe of the current root.
+    void reject_unverified()
+    {
+        RootSlot& slot = slots_.at(current_slot_);
+        slot.unverified.for_each([&](NodeId id) { slot.stripes[id] = {}; });
+        slot.unverified = NodeSet(N_);
     }
 
     // 辅助获取数据
-    const std::map<NodeId, std::vector<Byte>>& get_shards() const
+    /// Views of the current root's stripes in ascending index order; valid
+    /// until the next observe_* call.
+    std::vector<ShardView> get_shards() const
     {
-        if (!current_root_) {
-            throw std::runtime_error("No current root set");
+        const RootSlot& slot = current_slot();
+        std::vector<ShardView> shards;
+        shards.reserve(static_cast<std::size_t>(slot.held.count()));
+        slot.held.for_each([&](NodeId id) { shards.push_back({ .index = id, .data = slot.stripes[id].span() }); });
+        return shards;
+    }
+    /// Like get_shards(), with the unverified stripes merged in.
+    std::vector<ShardView> get_candidate_shards() const
+    {
+        const RootSlot& slot = current_slot();
+        std::vector<ShardView> shards;
+        shards.reserve(static_cast<std::size_t>(slot.held.count() + slot.unverified.count()));
+        for (NodeId id = 0; id < N_; ++id) {
+            if (slot.held.contains(id) || slot.unverified.contains(id))
+                shards.push_back({ .index = id, .data = slot.stripes[id].span() });
         }
-        auto root = *current_root_;
-        return stripes_.at(root);
+        return shards;
+    }
+    /// Stripe received from `id` for the current root; empty if none.
+    const SharedBytes& get_shard(NodeId id) const
+    {
+        return current_slot().stripes.at(id);
     }
     Hash get_current_root() const
     {
@@ -134,19 +337,39 @@ public:
     void mark_echo_sent()
     {
         echo_sent_ = true;
-        if (current_root_) {
-            echo_senders_[*current_root_].insert(pid_);
+        if (current_slot_ >= 0 && echoed_.insert(pid_)) {
+            slots_[current_slot_].echoes.insert(pid_);
         }
     }
     void mark_ready_sent()
     {
         ready_sent_ = true;
-        if (current_root_) {
-            ready_senders_[*current_root_].insert(pid_);
+        if (current_slot_ >= 0 && readied_.insert(pid_)) {
+            slots_[current_slot_].readies.insert(pid_);
         }
     }
 
 private:
+    struct EchoProof {
+        size_t proof_index = 0;
+        MerklePath merkle_path;
+    };
+
+    // Everything known about one candidate root. Honest nodes only vote for
+    // the leader's root, and each sender's first vote is the only one counted,
+    // so there is rarely more than one slot. The table is capped at
+    // max_slots(): a vote naming a root beyond the cap is dropped uncounted,
+    // and only the VAL's root may evict a candidate.
+    struct RootSlot {
+        Hash root;
+        NodeSet echoes;
+        NodeSet readies;
+        NodeSet held; ///< senders whose verified stripe is in `stripes`
+        NodeSet unverified; ///< senders whose stripe in `stripes` is unchecked
+        std::vector<SharedBytes> stripes; ///< indexed by NodeId
+        std::vector<EchoProof> proofs; ///< indexed by NodeId; sized on first unverified ECHO
+    };
+
     // 配置参数
     int sid_, pid_, N_, f_, leader_;
 
@@ -156,10 +379,96 @@ private:
     bool ready_sent_ = false;
 
     std::optional<Hash> current_root_;
+    int current_slot_ = -1;
+
+    std::vector<RootSlot> slots_;
+    NodeSet echoed_; ///< senders whose ECHO was counted, for any root
+    NodeSet readied_; ///< senders whose READY was counted, for any root
+    NodeSet stripe_senders_; ///< senders whose unverified stripe was taken, for any root
+
+    int find_slot_index(const Hash& root) const
+    {
+        for (std::size_t i = 0; i < slots_.size(); ++i) {
+            if (slots_[i].root == root)
+                return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    const RootSlot* find_slot(const Hash& root) const
+    {
+        int i = find_slot_index(root);
+        return i < 0 ? nullptr : &slots_[i];
+    }
+
+    // The root's slot, created if the table has room; null if it is full.
+    RootSlot* slot_for(const Hash& root)
+    {
+        if (int i = find_slot_index(root); i >= 0)
+            return &slots_[i];
+        if (slots_.size() >= max_slots())
+            return nullptr;
+        return &slots_.emplace_back(RootSlot {
+            .root = root,
+            .echoes = NodeSet(N_),
+            .readies = NodeSet(N_),
+            .held = NodeSet(N_),
+            .unverified = NodeSet(N_),
+            .stripes = std::vector<SharedBytes>(N_),
+            .proofs = {},
+        });
+    }
+
+    // Slot for `sender`'s first vote in `voted`, which records the vote;
+    // null if it is not a first vote or its root has no room.
+    RootSlot* first_vote_slot(NodeSet& voted, int sender, const Hash& root)
+    {
+        if (sender < 0 || sender >= N_ || voted.contains(sender))
+            return nullptr;
+        RootSlot* slot = slot_for(root);
+        if (slot != nullptr)
+            voted.insert(sender);
+        return slot;
+    }
+
+    // Drops the non-current slot with the fewest votes. Its voters' votes
+    // went with it, so they may cast them again.
+    void evict_weakest()
+    {
+        int weakest = -1;
+        int fewest = 0;
+        for (int i = 0; i < static_cast<int>(slots_.size()); ++i) {
+            const int votes = slots_[i].echoes.count() + slots_[i].readies.count();
+            if (i != current_slot_ && (weakest < 0 || votes < fewest)) {
+                weakest = i;
+                fewest = votes;
+            }
+        }
+        if (weakest < 0)
+            return;
+        slots_[weakest].echoes.for_each([&](NodeId id) { echoed_.erase(id); });
+        slots_[weakest].readies.for_each([&](NodeId id) { readied_.erase(id); });
+        slots_.erase(slots_.begin() + weakest);
+        if (current_slot_ > weakest)
+            --current_slot_;
+    }
 
-    std::map<Hash, std::map<int, std::vector<Byte>>> stripes_;
-    std::map<Hash, std::set<int>> echo_senders_;
-    std::map<Hash, std::set<int>> ready_senders_;
+    const RootSlot& current_slot() const
+    {
+        if (current_slot_ < 0) {
+            throw std::runtime_error("No current root set");
+        }
+        return slots_[current_slot_];
+    }
+
+    void store_stripe(RootSlot& slot, NodeId id, SharedBytes&& stripe)
+    {
+        if (id < 0 || id >= N_)
+            return;
+        slot.unverified.erase(id);
+        slot.held.insert(id);
+        slot.stripes[id] = std::move(stripe);
+    }
 };
 
 } // namespace Honey::BFT::RBC
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "core/async_inbox.hpp"
+#include "core/common.hpp"
+#include "core/concepts.hpp"
+#include "core/rbc/messages.hpp"
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace Honey::BFT::RBC {
+
+/// One RBC instance: the epoch and the node whose value it disperses.
+struct SessionKey {
+    std::uint64_t epoch;
+    NodeId proposer;
+
+    friend bool operator==(const SessionKey&, const SessionKey&) = default;
+};
+
+/// Messages of one instance as routed by an RBCMux; ends once it is retired.
+class RBCChannel {
+public:
+    using Inbox = AsyncInbox<std::optional<RBCMessage>>;
+
+    explicit RBCChannel(std::shared_ptr<Inbox> inbox)
+        : inbox_(std::move(inbox))
+    {
+    }
+
+    auto next() { return inbox_->next(); }
+
+private:
+    std::shared_ptr<Inbox> inbox_;
+};
+
+static_assert(AsyncStreamOf<RBCChannel, RBCMessage>);
+
+/**
+ * @brief Demultiplexes one inbound RBC stream into per-instance channels.
+ *
+ * An instance's messages carry `session_id(key)`, i.e. epoch * N + proposer.
+ * The table covers `epoch_window` consecutive epochs of N slots, starting at
+ * the oldest epoch not yet retired, so routing a message is one index
+ * computation. A message for an instance nobody opened yet creates it and
+ * waits in its channel until open() hands the channel to the instance's
+ * `ReliableBroadcast::run`. Until then it keeps at most
+ * `early_per_kind` messages of each payload type from each sender, so
+ * peers cannot fill memory with instances nobody runs. Messages beyond
+ * that, for retired epochs, for epochs past the window or with a malformed
+ * session id are dropped and counted.
+ *
+ * Not thread-safe: run(), open() and retire_before() must be called from the
+ * thread that drives the instances. A channel push resumes its instance
+ * inline, and that instance may call back into the mux.
+ */
+template <AsyncStreamOf<RBCMessage> Stream>
+class RBCMux {
+public:
+    /// An honest peer sends at most two messages of a type per instance: a
+    /// pushed FRAGMENT and the proven one it may be asked for.
+    static constexpr std::uint8_t early_per_kind = 2;
+
+    RBCMux(int N, Stream inbound, std::size_t epoch_window = 2)
+        : N_(N)
+        , window_(epoch_window)
+        , inbound_(std::move(inbound))
+    {
+        if (N <= 0 || N > MAX_NODES || epoch_window == 0) {
+            throw std::invalid_argument("RBCMux needs 0 < N <= MAX_NODES and a non-empty epoch window");
+        }
+        slots_.resize(static_cast<std::size_t>(N) * epoch_window);
+    }
+
+    /**
+     * @brief Session id that routes a message to instance `key`.
+     *
+     * @throws std::overflow_error if the epoch does not fit the id
+     */
+    [[nodiscard]] int session_id(SessionKey key) const
+    {
+        if (key.epoch > static_cast<std::uint64_t>((INT_MAX - key.proposer) / N_)) {
+            throw std::overflow_error("RBC epoch does not fit in a session id");
+        }
+        return static_cast<int>(key.epoch) * N_ + key.proposer;
+    }
+
+    /**
+     * @brief Channel of instance `key`, with whatever arrived for it so far.
+     *
+     * @throws std::out_of_range if the instance lies outside the window
+     * @throws std::logic_error if it was opened already
+     */
+    [[nodiscard]] RBCChannel open(SessionKey key)
+    {
+        Slot* slot = slot_for(key);
+        if (slot == nullptr) {
+            throw std::out_of_range("RBC instance outside the mux's epoch window");
+        }
+        if (slot->opened) {
+            throw std::logic_error("RBC instance opened twice");
+        }
+        slot->opened = true;
+        slot->early = {};
+        return RBCChannel(slot->inbox);
+    }
+
+    /// Routes the inbound stream until it ends, then ends every channel.
+    template <template <typename> typename TaskT>
+    auto run() -> TaskT<void>
+    {
+        while (auto msg = co_await inbound_.next()) {
+            dispatch(std::move(*msg));
+        }
+        close(slots_.begin(), slots_.end());
+    }
+
+    /// Ends the channels of every epoch before `epoch` and frees their slots.
+    void retire_before(std::uint64_t epoch)
+    {
+        if (epoch <= base_) {
+            return;
+        }
+        const std::uint64_t retired = std::min<std::uint64_t>(epoch - base_, window_);
+        const auto first = static_cast<std::size_t>(base_ % window_);
+        base_ = epoch;
+
+        // The retired epochs are `retired` consecutive rows of the ring
+        std::vector<std::shared_ptr<RBCChannel::Inbox>> ended;
+        for (std::uint64_t i = 0; i < retired; ++i) {
+            const std::size_t row = (first + i) % window_;
+            const auto begin = slots_.begin() + static_cast<std::ptrdiff_t>(row * N_);
+            take(begin, begin + N_, ended);
+        }
+        end_all(ended);
+    }
+
+    [[nodiscard]] std::uint64_t oldest_epoch() const noexcept { return base_; }
+
+    /// Messages discarded since construction.
+    [[nodiscard]] std::size_t dropped() const noexcept { return dropped_; }
+
+private:
+    struct Slot {
+        std::shared_ptr<RBCChannel::Inbox> inbox; ///< null while free
+        bool opened = false;
+        std::vector<std::uint8_t> early; ///< held per (sender, payload type) until opened
+    };
+
+    static constexpr std::size_t kinds = std::variant_size_v<RBCPayload>;
+
+    int N_;
+    std::size_t window_;
+    Stream inbound_;
+    // Row e % window_ holds epoch e: the window never spans two epochs
+    // with the same residue.
+    std::vector<Slot> slots_;
+    std::uint64_t base_ = 0;
+    std::size_t dropped_ = 0;
+
+    // The instance's slot, created on first use; null outside the window
+    Slot* slot_for(SessionKey key)
+    {
+        if (key.proposer < 0 || key.proposer >= N_ || key.epoch < base_ || key.epoch - base_ >= window_) {
+            return nullptr;
+        }
+        Slot& slot = slots_[(static_cast<std::size_t>(key.epoch % window_) * N_) + key.proposer];
+        if (!slot.inbox) {
+            slot.inbox = std::make_shared<RBCChannel::Inbox>();
+        }
+        return &slot;
+    }
+
+    void dispatch(RBCMessage&& msg)
+    {
+        Slot* slot = msg.session_id < 0
+            ? nullptr
+            : slot_for({ .epoch = static_cast<std::uint64_t>(msg.session_id / N_), .proposer = msg.session_id % N_ });
+        if (slot == nullptr || (!slot->opened && !hold_early(*slot, msg))) {
+            ++dropped_;
+            return;
+        }
+        // Held here: the instance resumed by the push may retire its own slot
+        const auto inbox = slot->inbox;
+        inbox->push(std::move(msg));
+    }
+
+    // Counts a message against its sender's quota for an unopened slot
+    bool hold_early(Slot& slot, const RBCMessage& msg) const
+    {
+        if (msg.sender < 0 || msg.sender >= N_) {
+            return false;
+        }
+        if (slot.early.empty()) {
+            slot.early.resize(static_cast<std::size_t>(N_) * kinds);
+        }
+        std::uint8_t& held = slot.early[(static_cast<std::size_t>(msg.sender) * kinds) + msg.payload.index()];
+        if (held >= early_per_kind) {
+            return false;
+        }
+        ++held;
+        return true;
+    }
+
+    template <typename It>
+    static void take(It begin, It end, std::vector<std::shared_ptr<RBCChannel::Inbox>>& ended)
+    {
+        for (auto it = begin; it != end; ++it) {
+            if (it->inbox) {
+                ended.push_back(std::exchange(it->inbox, {}));
+            }
+            it->opened = false;
+            it->early = {};
+        }
+    }
+
+    template <typename It>
+    void close(It begin, It end)
+    {
+        std::vector<std::shared_ptr<RBCChannel::Inbox>> ended;
+        take(begin, end, ended);
+        end_all(ended);
+    }
+
+    // Only after the table is consistent again: each push may resume an
+    // instance that calls back into the mux
+    static void end_all(const std::vector<std::shared_ptr<RBCChannel::Inbox>>& ended)
+    {
+        for (const auto& inbox : ended) {
+            inbox->push(std::nullopt);
+        }
+    }
+};
+
+} // namespace Honey::BFT::RBC
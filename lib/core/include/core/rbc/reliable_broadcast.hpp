@@ -1,14 +1,50 @@
 #pragma once
 
+#include "core/async_inbox.hpp"
 #include "core/common.hpp"
 #include "core/concepts.hpp"
+#include "core/detached.hpp"
 #include "core/rbc/concept.hpp"
 #include "core/rbc/messages.hpp"
 #include "core/rbc/rbc_core.hpp"
+#include "core/when_all.hpp"
+#include <deque>
+#include <exception>
+#include <expected>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace Honey::BFT::RBC {
 
+/// Tuning knobs of one ReliableBroadcast instance.
+struct RBCOptions {
+    /// Merkle verifications of VAL/ECHO stripes that may run at once. With 1,
+    /// each message is verified before the next one is read. Above 1,
+    /// verifications run off the receive loop and their results are applied
+    /// in completion order.
+    std::size_t max_inflight_verifications = 1;
+    /// Count ECHOs as votes on arrival but check their stripes only once the
+    /// READY quorum is in, and then only as many as decoding needs. If
+    /// decoding the checked stripes fails, the rest are checked and decoding
+    /// is retried, so no unchecked stripe ever reaches the decoder.
+    bool lazy_echo_verification = false;
+    /// Start decoding in the background once N-2f verified stripes of the
+    /// current root are held, instead of after the READY quorum. The result
+    /// is kept until 2f+1 READYs release it, taking the decode off the path
+    /// after the last READY. Where the decode runs is up to the crypto
+    /// service's async_decode; the receive loop keeps draining meanwhile.
+    /// With lazy_echo_verification, stripes are then checked as soon as
+    /// enough have arrived to decode, not at the READY quorum.
+    bool speculative_decode = false;
+};
+
 template <Transceiver T, CryptoService C>
 class ReliableBroadcast {
 private:
@@ -18,6 +54,14 @@ private:
     T& transport_;
     C& crypto_;
     RBCCore core_;
+    RBCOptions options_;
+
+    // Proof of our own stripe, from the VAL; our ECHO carries it on
+    std::size_t val_proof_index_ = 0;
+    MerklePath val_merkle_path_;
+    // Verified stripes held when decoding last failed; the next attempt
+    // waits for more
+    int failed_decode_shards_ = 0;
 
     using Tree = typename C::MerkleTreeType;
 
@@ -28,7 +72,8 @@ public:
         NodeId my_pid,
         NodeId leader,
         T& transport,
-        C& crypto)
+        C& crypto,
+        RBCOptions options = {})
         : system_ctx_(system_ctx)
         , sid_(sid)
         , my_pid_(my_pid)
@@ -36,81 +81,349 @@ public:
         , transport_(transport)
         , crypto_(crypto)
         , core_({ .session_id = sid, .node_id = my_pid, .total_nodes = system_ctx.N, .fault_tolerance = system_ctx.f, .leader_id = leader })
+        , options_(options)
     {
     }
 
     template <template <typename> typename TaskT, AsyncStreamOf<RBCMessage> Stream>
     auto run(std::optional<std::vector<Byte>> input, Stream stream) -> TaskT<RBCOutput>
     {
-        if (core_.is_leader(my_pid_) && input) {
-            Tree tree = co_await crypto_.async_build_merkle_tree(
-                system_ctx_.N - system_ctx_.f,
-                system_ctx_.N,
-                BytesSpan { *input });
-            co_await broadcast_val<TaskT>(tree);
+        if (options_.max_inflight_verifications > 1 || options_.speculative_decode) {
+            return run_pipelined<TaskT>(std::move(input), std::move(stream));
         }
+        return run_serial<TaskT>(std::move(input), std::move(stream));
+    }
+
+private:
+    template <template <typename> typename TaskT, AsyncStreamOf<RBCMessage> Stream>
+    auto run_serial(std::optional<std::vector<Byte>> input, Stream stream) -> TaskT<RBCOutput>
+    {
+        co_await disperse<TaskT>(std::move(input));
 
         while (auto msg_opt = co_await stream.next()) {
-            RBCMessage msg = *msg_opt;
+            RBCMessage msg = std::move(*msg_opt);
 
             // --- Step A: 验证与更新 Core (Logic) ---
-            if (auto* p = std::get_if<ValPayload>(&msg.payload)) {
-                if (!co_await crypto_.async_verify_merkle(p->stripe, p->proof_index, p->merkle_path, p->root_hash))
-                    continue;
+            if (needs_proof(msg) && !co_await verify(msg))
+                continue;
+            apply(std::move(msg));
 
-                if (!core_.is_valid_val(msg.sender, *p))
-                    continue;
+            // --- Step B: 基于 Core 的状态决定副作用 (Flow Control) ---
+            if (auto output = co_await react<TaskT>())
+                co_return std::move(*output);
+        }
+
+        // co_return std::vector<Byte> {};
+        // Or should we throw an exception here?
+        throw std::runtime_error("RBC terminated without delivering output");
+    }
+
+    // Outcome of a background read, verification or decode, posted to the
+    // run loop
+    struct Incoming {
+        std::optional<RBCMessage> msg;
+    };
+    struct Verified {
+        RBCMessage msg;
+        bool ok;
+    };
+    struct Decoded {
+        std::expected<RBCOutput, std::error_code> result;
+    };
+    using PipelineEvent = std::variant<Incoming, Verified, Decoded, std::exception_ptr>;
+
+    // Shared with the background coroutines, which may outlive run(): a
+    // pending read, verification or decode finishes into an inbox nobody
+    // drains.
+    template <typename Stream>
+    struct Pipeline {
+        Stream stream;
+        AsyncInbox<PipelineEvent> inbox;
+    };
+
+    /*
+     * At most one read and `max_inflight_verifications` verifications are
+     * outstanding. READYs are applied on arrival, VAL/ECHOs once verified,
+     * and the thresholds are rechecked after every applied message, so a
+     * quorum is acted on as soon as its last verification completes.
+     *
+     * With speculative_decode, one decode is started as soon as enough
+     * verified stripes are held and the loop keeps running until its result
+     * is in; the READY quorum then delivers it. Should it fail, it is
+     * retried once more stripes are held.
+     */
+    template <template <typename> typename TaskT, AsyncStreamOf<RBCMessage> Stream>
+    auto run_pipelined(std::optional<std::vector<Byte>> input, Stream stream) -> TaskT<RBCOutput>
+    {
+        co_await disperse<TaskT>(std::move(input));
+
+        auto pipeline = std::make_shared<Pipeline<Stream>>(std::move(stream));
+        std::deque<RBCMessage> waiting; // VAL/ECHOs not yet handed to the verifier
+        std::size_t verifying = 0;
+        bool reading = true;
+        bool decoding = false;
+        std::optional<std::expected<RBCOutput, std::error_code>> decoded;
+        read_in_background(pipeline);
+
+        while (reading || verifying > 0 || !waiting.empty() || decoding) {
+            while (!waiting.empty() && verifying < options_.max_inflight_verifications) {
+                ++verifying;
+                verify_in_background(pipeline, std::move(waiting.front()));
+                waiting.pop_front();
+            }
 
-                core_.observe_val(msg.sender, *p);
-            } else if (auto* p = std::get_if<EchoPayload>(&msg.payload)) {
-                if (!co_await crypto_.async_verify_merkle(p->stripe, p->proof_index, p->merkle_path, p->root_hash))
+            PipelineEvent event = co_await pipeline->inbox.next();
+            if (auto* failure = std::get_if<std::exception_ptr>(&event))
+                std::rethrow_exception(*failure);
+
+            if (auto* incoming = std::get_if<Incoming>(&event)) {
+                if (!incoming->msg) {
+                    reading = false;
+                    continue;
+                }
+                read_in_background(pipeline);
+                if (needs_proof(*incoming->msg)) {
+                    waiting.push_back(std::move(*incoming->msg));
+                    continue;
+                }
+                apply(std::move(*incoming->msg));
+            } else if (auto* done = std::get_if<Decoded>(&event)) {
+                decoding = false;
+                decoded = std::move(done->result);
+            } else {
+                auto& verified = std::get<Verified>(event);
+                --verifying;
+                if (!verified.ok)
                     continue;
-                core_.observe_echo(msg.sender, *p);
-            } else if (auto* p = std::get_if<ReadyPayload>(&msg.payload)) {
-                core_.observe_ready(msg.sender, *p);
+                apply(std::move(verified.msg));
             }
 
-            // --- Step B: 基于 Core 的状态决定副作用 (Flow Control) ---
+            if (options_.speculative_decode) {
+                co_await announce<TaskT>();
+                // Speculation cannot wait for the READY quorum to check stripes
+                if (options_.lazy_echo_verification && core_.could_decode() && core_.missing_shards() > 0)
+                    co_await verify_unverified<TaskT>(core_.missing_shards());
+                if (decoding)
+                    continue;
 
-            // 规则 1: 收到 VAL 后，如果没有发送过 ECHO，则广播 ECHO
-            if (core_.has_received_val() && !core_.has_sent_echo()) {
-                auto echo_msg = construct_echo(core_.get_current_root());
-                co_await transport_.broadcast(echo_msg);
-                core_.mark_echo_sent(); // 通知 Core 更新状态
+                const bool failed = decoded && !decoded->has_value();
+                if (failed && options_.lazy_echo_verification && core_.can_output())
+                    co_await verify_unverified<TaskT>(std::numeric_limits<int>::max());
+                if ((!decoded || (failed && has_new_shards())) && core_.has_received_val() && core_.missing_shards() == 0) {
+                    failed_decode_shards_ = held_shards();
+                    decoded.reset();
+                    decoding = true;
+                    decode_in_background(pipeline);
+                } else if (decoded && decoded->has_value() && core_.can_output()) {
+                    co_return std::move(**decoded);
+                }
+                continue;
             }
 
-            // 规则 2: 满足阈值后，广播 READY
-            if (!core_.has_sent_ready() && core_.should_send_ready()) {
-                auto ready_msg = construct_ready(core_.get_current_root());
-                co_await transport_.broadcast(ready_msg);
-                core_.mark_ready_sent(); // 通知 Core 更新状态
+            if (auto output = co_await react<TaskT>())
+                co_return std::move(*output);
+        }
+
+        throw std::runtime_error("RBC terminated without delivering output");
+    }
+
+    template <typename Stream>
+    static Detached read_in_background(std::shared_ptr<Pipeline<Stream>> pipeline)
+    {
+        PipelineEvent event;
+        try {
+            // Named first: GCC 12 destroys a co_await result inside a braced
+            // initializer twice
+            std::optional<RBCMessage> msg = co_await pipeline->stream.next();
+            event = Incoming { std::move(msg) };
+        } catch (...) {
+            event = std::current_exception();
+        }
+        pipeline->inbox.push(std::move(event));
+    }
+
+    template <typename Stream>
+    Detached verify_in_background(std::shared_ptr<Pipeline<Stream>> pipeline, RBCMessage msg)
+    {
+        PipelineEvent event;
+        try {
+            const bool ok = co_await verify(msg);
+            event = Verified { std::move(msg), ok };
+        } catch (...) {
+            event = std::current_exception();
+        }
+        pipeline->inbox.push(std::move(event));
+    }
+
+    // Decodes the stripes held right now. The frame keeps its own references
+    // to them, as run() may return before the decode does.
+    template <typename Stream>
+    Detached decode_in_background(std::shared_ptr<Pipeline<Stream>> pipeline)
+    {
+        const auto shards = core_.get_shards();
+        std::vector<SharedBytes> stripes;
+        stripes.reserve(shards.size());
+        for (const ShardView& shard : shards) {
+            stripes.push_back(core_.get_shard(shard.index));
+        }
+
+        PipelineEvent event;
+        try {
+            auto result = co_await crypto_.async_decode(
+                data_shards(),
+                system_ctx_.N,
+                std::span<const ShardView> { shards },
+                core_.get_current_root());
+            event = Decoded { std::move(result) };
+        } catch (...) {
+            event = std::current_exception();
+        }
+        pipeline->inbox.push(std::move(event));
+    }
+
+    // Any N-2f stripes decode: that many are all a READY quorum guarantees.
+    [[nodiscard]] int data_shards() const { return system_ctx_.N - (2 * system_ctx_.f); }
+
+    // The leader encodes its input and sends every node its VAL.
+    template <template <typename> typename TaskT>
+    auto disperse(std::optional<std::vector<Byte>> input) -> TaskT<void>
+    {
+        if (core_.is_leader(my_pid_) && input) {
+            Tree tree = co_await crypto_.async_build_merkle_tree(
+                data_shards(),
+                system_ctx_.N,
+                BytesSpan { *input });
+            co_await broadcast_val<TaskT>(tree);
+        }
+    }
+
+    // Whether a message's stripe is checked before it is applied.
+    bool needs_proof(const RBCMessage& msg) const
+    {
+        if (std::holds_alternative<EchoPayload>(msg.payload))
+            return !options_.lazy_echo_verification;
+        return std::holds_alternative<ValPayload>(msg.payload);
+    }
+
+    // Checks the stripe of a VAL or ECHO against its root.
+    auto verify(const RBCMessage& msg)
+    {
+        if (const auto* p = std::get_if<ValPayload>(&msg.payload))
+            return crypto_.async_verify_merkle(p->stripe, p->proof_index, p->merkle_path, p->root_hash);
+        const auto& p = std::get<EchoPayload>(msg.payload);
+        return crypto_.async_verify_merkle(p.stripe, p.proof_index, p.merkle_path, p.root_hash);
+    }
+
+    // Feeds a message whose stripe, if any, has been verified to the core.
+    void apply(RBCMessage&& msg)
+    {
+        if (auto* p = std::get_if<ValPayload>(&msg.payload)) {
+            if (!core_.is_valid_val(msg.sender, *p))
+                return;
+            if (!core_.has_received_val()) {
+                val_proof_index_ = p->proof_index;
+                val_merkle_path_ = p->merkle_path;
             }
+            core_.observe_val(msg.sender, std::move(*p));
+        } else if (auto* p = std::get_if<EchoPayload>(&msg.payload)) {
+            if (options_.lazy_echo_verification)
+                core_.observe_unverified_echo(msg.sender, std::move(*p));
+            else
+                core_.observe_echo(msg.sender, std::move(*p));
+        } else if (auto* p = std::get_if<ReadyPayload>(&msg.payload)) {
+            core_.observe_ready(msg.sender, *p);
+        }
+    }
+
+    // Sends the ECHO and READY the core's state now calls for.
+    template <template <typename> typename TaskT>
+    auto announce() -> TaskT<void>
+    {
+        // 规则 1: 收到 VAL 后，如果没有发送过 ECHO，则广播 ECHO
+        if (core_.has_received_val() && !core_.has_sent_echo()) {
+            auto echo_msg = construct_echo(core_.get_current_root());
+            co_await transport_.broadcast(echo_msg);
+            core_.mark_echo_sent(); // 通知 Core 更新状态
+        }
+
+        // 规则 2: 满足阈值后，广播 READY
+        if (!core_.has_sent_ready() && core_.should_send_ready()) {
+            auto ready_msg = construct_ready(core_.get_current_root());
+            co_await transport_.broadcast(ready_msg);
+            core_.mark_ready_sent(); // 通知 Core 更新状态
+        }
+    }
+
+    // Sends whatever the core's state now calls for; yields the output once
+    // it can be delivered.
+    template <template <typename> typename TaskT>
+    auto react() -> TaskT<std::optional<RBCOutput>>
+    {
+        co_await announce<TaskT>();
 
-            if (core_.can_output()) {
-                auto shards = core_.get_shards();
-                auto result = co_await crypto_.async_decode(
-                    system_ctx_.N - system_ctx_.f,
-                    system_ctx_.N,
-                    shards);
-                co_return *result;
+        if (options_.lazy_echo_verification && !core_.can_output() && core_.could_output()) {
+            co_await verify_unverified<TaskT>(core_.missing_shards());
+        }
+
+        if (core_.can_output() && has_new_shards()) {
+            auto result = co_await decode<TaskT>();
+            if (!result && options_.lazy_echo_verification
+                && core_.count_unverified(core_.get_current_root()) > 0) {
+                co_await verify_unverified<TaskT>(std::numeric_limits<int>::max());
+                result = co_await decode<TaskT>();
             }
+            if (result)
+                co_return std::move(*result);
+            // Every stripe held passed its check, so none can be singled out
+            // as bad; a decode from more of them may still succeed
+            failed_decode_shards_ = held_shards();
         }
+        co_return std::nullopt;
+    }
 
-        // co_return std::vector<Byte> {};
-        // Or should we throw an exception here?
-        throw std::runtime_error("RBC terminated without delivering output");
+    [[nodiscard]] int held_shards() const { return core_.count_shards(core_.get_current_root()); }
+    // Whether stripes came in since decoding last failed
+    [[nodiscard]] bool has_new_shards() const { return held_shards() > failed_decode_shards_; }
+
+    template <template <typename> typename TaskT>
+    auto decode() -> TaskT<std::expected<RBCOutput, std::error_code>>
+    {
+        const auto shards = core_.get_shards();
+        co_return co_await crypto_.async_decode(
+            data_shards(),
+            system_ctx_.N,
+            std::span<const ShardView> { shards },
+            core_.get_current_root());
+    }
+
+    // Checks unverified ECHO stripes of the current root, data shards first,
+    // until `wanted` of them passed or none are left.
+    template <template <typename> typename TaskT>
+    auto verify_unverified(int wanted) -> TaskT<void>
+    {
+        const Hash root = core_.get_current_root();
+        for (const auto& echo : core_.unverified_echoes()) {
+            if (wanted <= 0)
+                break;
+            if (co_await crypto_.async_verify_merkle(echo.stripe, echo.proof_index, echo.merkle_path, root)) {
+                core_.accept_echo(echo.sender);
+                --wanted;
+            } else {
+                core_.reject_echo(echo.sender);
+            }
+        }
     }
 
-private:
     RBCMessage construct_echo(const Hash& root)
     {
-        auto stripes = core_.get_shards();
         return RBCMessage {
             .sender = my_pid_,
             .session_id = sid_,
             .payload = EchoPayload {
                 .root_hash = root,
-                .stripe = stripes.at(my_pid_) }
+                .proof_index = val_proof_index_,
+                .merkle_path = val_merkle_path_,
+                .stripe = core_.get_shard(my_pid_) }
         };
     }
     RBCMessage construct_ready(const Hash& root)
@@ -122,17 +435,27 @@ private:
                 .root_hash = root }
         };
     }
+    // Builds every VAL first, then sends them all at once so the fan-out
+    // takes as long as the slowest send rather than the sum of them.
     template <template <typename> typename TaskT>
     auto broadcast_val(Tree tree) -> TaskT<void>
     {
+        std::vector<RBCMessage> vals;
+        vals.reserve(system_ctx_.N);
         for (int i = 0; i < system_ctx_.N; ++i) {
-            RBCMessage msg {
+            vals.push_back(RBCMessage {
                 .sender = my_pid_,
                 .session_id = sid_,
-                .payload = std::move(crypto_.extract_val_payload(tree, i))
-            };
-            co_await transport_.unicast(i, msg);
+                .payload = crypto_.extract_val_payload(tree, i) });
+        }
+
+        using Send = decltype(transport_.unicast(NodeId {}, vals.front()));
+        std::vector<Send> sends;
+        sends.reserve(vals.size());
+        for (int i = 0; i < system_ctx_.N; ++i) {
+            sends.push_back(transport_.unicast(i, vals[i]));
         }
+        co_await when_all(std::move(sends));
     }
 };
 
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Honey::BFT {
+
+/**
+ * @brief Immutable, reference-counted view of a run of `T`.
+ *
+ * Copies and slices share the underlying storage, so a message holding one
+ * can be queued for every peer without copying its bytes. The storage is
+ * either a vector adopted on construction or any buffer kept alive by an
+ * owner handle, e.g. `ErasureCode::ShardArena::storage()`.
+ */
+template <typename T>
+class SharedBuffer {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    SharedBuffer() = default;
+
+    /// Takes ownership of `values`; an lvalue is copied once, here.
+    SharedBuffer(std::vector<T> values) // NOLINT(google-explicit-constructor)
+    {
+        if (values.empty())
+            return;
+        auto holder = std::make_shared<const std::vector<T>>(std::move(values));
+        data_ = holder->data();
+        size_ = holder->size();
+        owner_ = std::move(holder);
+    }
+
+    /// Borrows `view`; `owner` must keep it alive.
+    SharedBuffer(std::span<const T> view, std::shared_ptr<const void> owner) noexcept
+        : owner_(std::move(owner))
+        , data_(view.data())
+        , size_(view.size())
+    {
+    }
+
+    [[nodiscard]] const T* data() const noexcept { return data_; }
+    [[nodiscard]] std::size_t size() const noexcept { return size_; }
+    [[nodiscard]] bool empty() const noexcept { return size_ == 0; }
+
+    [[nodiscard]] const_iterator begin() const noexcept { return data_; }
+    [[nodiscard]] const_iterator end() const noexcept { return data_ + size_; }
+
+    [[nodiscard]] const T& operator[](std::size_t i) const noexcept { return data_[i]; }
+
+    [[nodiscard]] std::span<const T> span() const noexcept { return { data_, size_ }; }
+    operator std::span<const T>() const noexcept { return span(); } // NOLINT(google-explicit-constructor)
+
+    /**
+     * @brief `count` elements starting at `offset`, sharing this storage.
+     *
+     * @throws std::out_of_range if the range does not fit
+     */
+    [[nodiscard]] SharedBuffer slice(std::size_t offset, std::size_t count) const
+    {
+        if (offset > size_ || count > size_ - offset) {
+            throw std::out_of_range("SharedBuffer::slice out of range");
+        }
+        return SharedBuffer(std::span<const T>(data_ + offset, count), owner_);
+    }
+
+    /// Ownership handle for the viewed storage; null for an empty buffer.
+    [[nodiscard]] const std::shared_ptr<const void>& storage() const noexcept { return owner_; }
+
+    friend bool operator==(const SharedBuffer& a, const SharedBuffer& b)
+    {
+        return std::ranges::equal(a.span(), b.span());
+    }
+
+private:
+    std::shared_ptr<const void> owner_;
+    const T* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+using SharedBytes = SharedBuffer<std::byte>;
+
+} // namespace Honey::BFT
@@ -0,0 +1,168 @@
+#pragma once
+
+#include "core/concepts.hpp"
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Honey::BFT {
+
+namespace detail {
+
+    // Counts outstanding awaitables plus the waiter itself; whoever brings it
+    // to zero resumes the waiter.
+    class WhenAllLatch {
+    public:
+        explicit WhenAllLatch(std::size_t count) noexcept
+            : remaining_(count + 1)
+        {
+        }
+
+        /// Registers the waiter; false if everything already finished.
+        bool try_await(std::coroutine_handle<> waiter) noexcept
+        {
+            waiter_ = waiter;
+            return remaining_.fetch_sub(1, std::memory_order_acq_rel) > 1;
+        }
+
+        /// Called by each finished awaitable; returns what to resume next.
+        std::coroutine_handle<> notify() noexcept
+        {
+            if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                return waiter_;
+            }
+            return std::noop_coroutine();
+        }
+
+        void set_exception(std::exception_ptr ep) noexcept
+        {
+            std::lock_guard lock(mutex_);
+            if (!exception_) {
+                exception_ = std::move(ep);
+            }
+        }
+
+        void rethrow_if_failed() const
+        {
+            if (exception_) {
+                std::rethrow_exception(exception_);
+            }
+        }
+
+    private:
+        std::atomic<std::size_t> remaining_;
+        std::coroutine_handle<> waiter_;
+        std::mutex mutex_;
+        std::exception_ptr exception_;
+    };
+
+    // Lazily started coroutine that awaits one operand and reports to the latch.
+    class WhenAllTask {
+    public:
+        struct promise_type {
+            WhenAllLatch* latch = nullptr;
+
+            WhenAllTask get_return_object() noexcept
+            {
+                return WhenAllTask { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            auto final_suspend() noexcept
+            {
+                struct Notify {
+                    bool await_ready() const noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) const noexcept
+                    {
+                        return h.promise().latch->notify();
+                    }
+                    void await_resume() const noexcept { }
+                };
+                return Notify {};
+            }
+
+            void return_void() noexcept { }
+            void unhandled_exception() noexcept { latch->set_exception(std::current_exception()); }
+        };
+
+        explicit WhenAllTask(std::coroutine_handle<promise_type> h) noexcept
+            : handle_(h)
+        {
+        }
+        WhenAllTask(WhenAllTask&& other) noexcept
+            : handle_(std::exchange(other.handle_, {}))
+        {
+        }
+        WhenAllTask(const WhenAllTask&) = delete;
+        WhenAllTask& operator=(const WhenAllTask&) = delete;
+        ~WhenAllTask()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        void start(WhenAllLatch& latch) noexcept
+        {
+            handle_.promise().latch = &latch;
+            handle_.resume();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    template <Awaitable A>
+    WhenAllTask make_when_all_task(A awaitable)
+    {
+        co_await std::move(awaitable);
+    }
+
+} // namespace detail
+
+/**
+ * @brief Awaits every operand concurrently and resumes once all finished.
+ *
+ * All operands are started before the caller suspends, so the total wait
+ * is the slowest operand rather than the sum. Results are discarded. If
+ * any operand throws, the first exception is rethrown after the rest
+ * finished. Operands may complete on any thread.
+ */
+template <Awaitable A>
+auto when_all(std::vector<A> awaitables)
+{
+    class Awaiter {
+    public:
+        explicit Awaiter(std::vector<A>&& awaitables)
+            : latch_(awaitables.size())
+        {
+            tasks_.reserve(awaitables.size());
+            for (A& a : awaitables) {
+                tasks_.push_back(detail::make_when_all_task(std::move(a)));
+            }
+        }
+
+        bool await_ready() const noexcept { return tasks_.empty(); }
+
+        bool await_suspend(std::coroutine_handle<> waiter) noexcept
+        {
+            for (auto& task : tasks_) {
+                task.start(latch_);
+            }
+            return latch_.try_await(waiter);
+        }
+
+        void await_resume() const { latch_.rethrow_if_failed(); }
+
+    private:
+        detail::WhenAllLatch latch_;
+        std::vector<detail::WhenAllTask> tasks_;
+    };
+    return Awaiter { std::move(awaitables) };
+}
+
+} // namespace Honey::BFT
@@ -1,14 +1,51 @@
+#include "core/async_inbox.hpp"
 #include "core/common.hpp"
 #include "core/concepts.hpp"
+#include "core/rbc/hash_echo_broadcast.hpp"
+#include "core/rbc/rbc_mux.hpp"
 #include "core/rbc/reliable_broadcast.hpp"
+#include "core/when_all.hpp"
 #include "utils_simple_task.hpp"
 #include <algorithm>
+#include <cstdlib>
+#include <deque>
 #include <expected>
 #include <gtest/gtest.h>
+#include <memory>
+#include <new>
 #include <optional>
+#include <system_error>
+#include <utility>
 #include <variant>
 #include <vector>
 
+namespace {
+// Heap traffic seen by the replaced global operator new while counting is on
+struct AllocStats {
+    bool counting = false;
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    std::size_t large = 0; ///< allocations of at least `large_threshold` bytes
+    std::size_t large_threshold = 0;
+};
+AllocStats g_alloc;
+} // namespace
+
+void* operator new(std::size_t size)
+{
+    if (g_alloc.counting) {
+        ++g_alloc.allocations;
+        g_alloc.bytes += size;
+        if (size >= g_alloc.large_threshold)
+            ++g_alloc.large;
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc();
+}
+[[gnu::noinline]] void operator delete(void* p) noexcept { std::free(p); }
+[[gnu::noinline]] void operator delete(void* p, std::size_t /*size*/) noexcept { std::free(p); }
+
 namespace Honey::BFT::RBC {
 
 namespace {
@@ -41,9 +78,9 @@ namespace {
 
         [[nodiscard]] Hash root() const { return root_hash; }
 
-        [[nodiscard]] std::vector<Hash> prove(int /*node_id*/) const
+        [[nodiscard]] MerklePath prove(int /*node_id*/) const
         {
-            return std::vector<Hash> {};
+            return MerklePath {};
         }
 
         [[nodiscard]] std::vector<Byte> leaf(int node_id) const
@@ -75,7 +112,7 @@ namespace {
         InlineTask<bool> async_verify_merkle(
             BytesSpan stripe,
             size_t /*proof_index*/,
-            std::vector<Hash> /*merkle_path*/,
+            std::span<const Hash> /*merkle_path*/,
             const Hash& root)
         {
             if (static_cast<uint8_t>(root[0]) == 0xCC) {
@@ -84,15 +121,21 @@ namespace {
             co_return true;
         }
 
+        // Shards re-encode to the mock tree's root only
         InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
             int /*K*/, int /*N*/,
-            const std::map<int, std::vector<Byte>>& received_shards)
+            std::span<const ShardView> received_shards,
+            const Hash& root)
         {
             if (received_shards.empty()) {
                 co_return std::unexpected(std::make_error_code(std::errc::invalid_argument));
             }
+            if (static_cast<uint8_t>(root[0]) != 0xCC) {
+                co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
 
-            co_return received_shards.begin()->second;
+            const BytesSpan first = received_shards.front().data;
+            co_return std::vector<Byte>(first.begin(), first.end());
         }
 
         // ---------------------------------------------------------------------
@@ -116,7 +159,8 @@ namespace {
         {
             if (idx >= msgs.size())
                 co_return std::nullopt;
-            co_return msgs[idx++];
+            // Hand over ownership, as a network channel would
+            co_return std::move(msgs[idx++]);
         }
     };
 
@@ -381,4 +425,1417 @@ TEST_F(ReliableBroadcastTest, PartialEchoQuorumDoesNotTriggerReady)
     EXPECT_TRUE(std::holds_alternative<ReadyPayload>(transport.broadcasts[1].payload));
 }
 
+TEST_F(ReliableBroadcastTest, DeliveryDoesNotCopyReceivedStripes)
+{
+    constexpr std::size_t StripeSize = std::size_t { 256 } << 10;
+    for (auto& shard : shards) {
+        shard.assign(StripeSize, std::byte { 0x5A });
+    }
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    transport.broadcasts.reserve(2);
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    g_alloc = AllocStats { .counting = true, .large_threshold = StripeSize };
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    const RBCOutput output = task.get();
+    g_alloc.counting = false;
+
+    EXPECT_EQ(output.size(), StripeSize);
+    // Four stripes were received. Our ECHO and the mock transport's record of
+    // it share the VAL stripe, so the decoded output is the only stripe-sized
+    // allocation.
+    EXPECT_EQ(g_alloc.large, 1U);
+    EXPECT_LT(g_alloc.bytes, StripeSize + (std::size_t { 16 } << 10));
+    RecordProperty("allocations", static_cast<int>(g_alloc.allocations));
+    RecordProperty("bytes_allocated", static_cast<int>(g_alloc.bytes));
+}
+
+TEST_F(ReliableBroadcastTest, EchoSharesTheValStripe)
+{
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    RBCMessage val = make_val(Leader, MyPid);
+    const Byte* val_bytes = std::get<ValPayload>(val.payload).stripe.data();
+    stream.msgs.push_back(std::move(val));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+
+    ASSERT_EQ(transport.broadcasts.size(), 1U);
+    const auto& echo = std::get<EchoPayload>(transport.broadcasts[0].payload);
+    EXPECT_EQ(echo.stripe.data(), val_bytes);
+    EXPECT_EQ(echo.stripe, SharedBytes(shards[MyPid]));
+}
+
+TEST_F(ReliableBroadcastTest, EchoCarriesTheValProof)
+{
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    RBCMessage val = make_val(Leader, MyPid);
+    auto& path = std::get<ValPayload>(val.payload).merkle_path;
+    path.push_back(mock_root);
+    path.push_back(Hash {});
+    const MerklePath sent_path = path;
+    stream.msgs.push_back(std::move(val));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+
+    // Peers check our stripe against the root with this proof
+    ASSERT_EQ(transport.broadcasts.size(), 1U);
+    const auto& echo = std::get<EchoPayload>(transport.broadcasts[0].payload);
+    EXPECT_EQ(echo.proof_index, static_cast<size_t>(MyPid));
+    EXPECT_EQ(echo.merkle_path, sent_path);
+}
+
+TEST_F(ReliableBroadcastTest, CopyingValOrEchoDoesNotAllocate)
+{
+    RBCMessage val = make_val(Leader, MyPid);
+    auto& path = std::get<ValPayload>(val.payload).merkle_path;
+    for (std::size_t i = 0; i < MAX_MERKLE_PATH; ++i) {
+        path.push_back(mock_root);
+    }
+    EXPECT_THROW(path.push_back(mock_root), std::length_error);
+    const RBCMessage echo = make_echo(2);
+
+    g_alloc = AllocStats { .counting = true, .large_threshold = 1 };
+    std::vector<RBCMessage> fan_out(N); // the only allocation
+    for (auto& copy : fan_out) {
+        copy = val;
+    }
+    const RBCMessage echo_copy = echo;
+    g_alloc.counting = false;
+
+    EXPECT_EQ(g_alloc.allocations, 1U);
+    EXPECT_EQ(std::get<ValPayload>(fan_out.back().payload).merkle_path, path);
+}
+
+TEST_F(ReliableBroadcastTest, LeaderSendsOneValPerNode)
+{
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, Leader, Leader, transport, crypto);
+
+    auto task = rbc.run<InlineTask>(original_message, VectorStream {});
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+
+    ASSERT_EQ(transport.unicasts.size(), static_cast<std::size_t>(N));
+    for (int i = 0; i < N; ++i) {
+        EXPECT_EQ(transport.unicasts[i].target, i);
+        const auto& val = std::get<ValPayload>(transport.unicasts[i].msg.payload);
+        EXPECT_EQ(val.proof_index, static_cast<size_t>(i));
+        EXPECT_EQ(val.stripe, SharedBytes(original_message));
+    }
+}
+
+namespace {
+    // Crypto whose Merkle checks stay pending until the test completes them
+    struct DeferredCryptoMock : CryptoMock {
+        struct Pending {
+            std::coroutine_handle<> handle;
+            size_t proof_index;
+            bool ok = true;
+        };
+        std::vector<std::shared_ptr<Pending>> pending;
+        std::size_t outstanding = 0;
+        std::size_t max_outstanding = 0;
+
+        struct Awaiter {
+            DeferredCryptoMock* self;
+            std::shared_ptr<Pending> record;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h)
+            {
+                record->handle = h;
+                self->pending.push_back(record);
+                self->max_outstanding = std::max(self->max_outstanding, ++self->outstanding);
+            }
+            bool await_resume() const noexcept { return record->ok; }
+        };
+
+        Awaiter async_verify_merkle(BytesSpan /*stripe*/, size_t proof_index, std::span<const Hash> /*merkle_path*/, const Hash& /*root*/)
+        {
+            return Awaiter { this, std::make_shared<Pending>(Pending { .handle = {}, .proof_index = proof_index }) };
+        }
+
+        void complete(std::size_t i, bool ok = true)
+        {
+            --outstanding;
+            pending[i]->ok = ok;
+            pending[i]->handle.resume();
+        }
+    };
+    static_assert(CryptoService<DeferredCryptoMock>);
+
+    std::size_t count_broadcasts_of_ready(const TransportMock& transport)
+    {
+        return std::ranges::count_if(transport.broadcasts, [](const RBCMessage& m) {
+            return std::holds_alternative<ReadyPayload>(m.payload);
+        });
+    }
+} // namespace
+
+TEST_F(ReliableBroadcastTest, PipelinedVerificationAppliesInCompletionOrder)
+{
+    DeferredCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .max_inflight_verifications = 2 });
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+
+    // The whole stream was read while only two stripes were being verified
+    ASSERT_EQ(deferred.pending.size(), 2U);
+    EXPECT_EQ(deferred.pending[0]->proof_index, static_cast<size_t>(MyPid));
+    EXPECT_EQ(deferred.pending[1]->proof_index, 0U);
+    EXPECT_TRUE(transport.broadcasts.empty());
+
+    // ECHO 0 finishes first and frees a slot for ECHO 2
+    deferred.complete(1);
+    ASSERT_EQ(deferred.pending.size(), 3U);
+    EXPECT_EQ(deferred.pending[2]->proof_index, 2U);
+
+    // With the VAL in, the READYs already applied complete delivery
+    deferred.complete(0);
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_EQ(deferred.max_outstanding, 2U);
+    ASSERT_EQ(transport.broadcasts.size(), 2U);
+    EXPECT_TRUE(std::holds_alternative<EchoPayload>(transport.broadcasts[0].payload));
+    EXPECT_TRUE(std::holds_alternative<ReadyPayload>(transport.broadcasts[1].payload));
+
+    // A verification still in flight after delivery finishes harmlessly
+    deferred.complete(2);
+}
+
+TEST_F(ReliableBroadcastTest, PipelinedVerificationSendsReadyOnLastNeededEcho)
+{
+    DeferredCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .max_inflight_verifications = 4 });
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    ASSERT_EQ(deferred.pending.size(), 4U);
+
+    deferred.complete(0);
+    ASSERT_EQ(transport.broadcasts.size(), 1U); // our ECHO
+    deferred.complete(3, false); // a bad stripe is dropped
+    deferred.complete(1);
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 0U);
+    // N-f = 3 ECHOs including ours: READY goes out before the last check
+    deferred.complete(2);
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 1U);
+
+    // Without READYs there is nothing to deliver
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+}
+
+namespace {
+    // Records which stripes were checked; `bad` ones fail, and decoding fails
+    // with fewer than `min_decode_shards` stripes
+    struct CountingCryptoMock : CryptoMock {
+        std::vector<size_t> verified;
+        std::vector<size_t> bad;
+        std::size_t min_decode_shards = 0;
+
+        InlineTask<bool> async_verify_merkle(BytesSpan /*stripe*/, size_t proof_index, std::span<const Hash> /*merkle_path*/, const Hash& /*root*/)
+        {
+            verified.push_back(proof_index);
+            co_return std::ranges::find(bad, proof_index) == bad.end();
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int K, int N, std::span<const ShardView> received_shards, const Hash& root)
+        {
+            if (received_shards.size() < min_decode_shards) {
+                co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
+            co_return co_await CryptoMock::async_decode(K, N, received_shards, root);
+        }
+    };
+    static_assert(CryptoService<CountingCryptoMock>);
+} // namespace
+
+TEST_F(ReliableBroadcastTest, LazyEchoVerificationChecksOnlyNeededStripes)
+{
+    CountingCryptoMock counting;
+    ReliableBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting,
+        { .lazy_echo_verification = true });
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+
+    // Unchecked ECHOs still count as votes for READY
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 1U);
+    // Our VAL stripe plus one ECHO make the N-2f needed to decode
+    EXPECT_EQ(counting.verified, (std::vector<size_t> { MyPid, 0 }));
+}
+
+TEST_F(ReliableBroadcastTest, LazyEchoVerificationSkipsBadStripes)
+{
+    CountingCryptoMock counting;
+    counting.bad = { 0 };
+    ReliableBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting,
+        { .lazy_echo_verification = true });
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_EQ(counting.verified, (std::vector<size_t> { MyPid, 0, 2 }));
+}
+
+TEST_F(ReliableBroadcastTest, LazyEchoVerificationChecksTheRestWhenDecodeFails)
+{
+    CountingCryptoMock counting;
+    counting.min_decode_shards = 3;
+    ReliableBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting,
+        { .lazy_echo_verification = true });
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_echo(2));
+    stream.msgs.push_back(make_echo(3));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_EQ(counting.verified, (std::vector<size_t> { MyPid, 0, 2, 3 }));
+}
+
+TEST_F(ReliableBroadcastTest, RejectsShardsThatDoNotCommitToTheRoot)
+{
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    std::ranges::fill(mock_root, std::byte { 0xDD }); // valid proofs, inconsistent shards
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+    stream.msgs.push_back(make_echo(2));
+
+    // Nothing is delivered, but the failed decode does not end the instance
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    try {
+        (void)task.get();
+        ADD_FAILURE() << "delivered";
+    } catch (const std::system_error&) {
+        ADD_FAILURE() << "gave up on the first failed decode";
+    } catch (const std::runtime_error&) {
+        // The stream ended first
+    }
+}
+
+namespace {
+    // Stripe i is the single byte i. A proof checks out only for the leaf
+    // its stripe belongs to, and decoding only if every stripe sits at its
+    // own index, as re-encoding against the root would find.
+    struct IndexedCryptoMock : CryptoMock {
+        InlineTask<bool> async_verify_merkle(BytesSpan stripe, size_t proof_index, std::span<const Hash> /*merkle_path*/, const Hash& /*root*/)
+        {
+            co_return stripe.size() == 1 && std::to_integer<size_t>(stripe.front()) == proof_index;
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int /*K*/, int /*N*/, std::span<const ShardView> received_shards, const Hash& /*root*/)
+        {
+            for (const ShardView& shard : received_shards) {
+                if (shard.data.size() != 1 || std::to_integer<int>(shard.data.front()) != shard.index)
+                    co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
+            co_return std::vector<Byte> { std::byte { 42 } };
+        }
+    };
+    static_assert(CryptoService<IndexedCryptoMock>);
+
+    RBCMessage indexed_echo(const Hash& root, int sender, int leaf)
+    {
+        return RBCMessage {
+            .sender = sender,
+            .session_id = 100,
+            .payload = EchoPayload {
+                .root_hash = root,
+                .proof_index = static_cast<size_t>(leaf),
+                .merkle_path = {},
+                .stripe = std::vector<Byte> { static_cast<std::byte>(leaf) } }
+        };
+    }
+} // namespace
+
+TEST_F(ReliableBroadcastTest, IgnoresEchoesReplayedByAnotherPeer)
+{
+    for (const bool lazy : { false, true }) {
+        IndexedCryptoMock indexed;
+        ReliableBroadcast<TransportMock, IndexedCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, indexed,
+            { .lazy_echo_verification = lazy });
+        VectorStream stream;
+        RBCMessage val = make_val(Leader, MyPid);
+        std::get<ValPayload>(val.payload).stripe = std::vector<Byte> { static_cast<std::byte>(MyPid) };
+        stream.msgs.push_back(std::move(val));
+        // 3 passes off 2's ECHO, valid proof and all, as its own
+        stream.msgs.push_back(indexed_echo(mock_root, 3, 2));
+        stream.msgs.push_back(indexed_echo(mock_root, 0, 0));
+        stream.msgs.push_back(make_ready(0));
+        stream.msgs.push_back(make_ready(2));
+        stream.msgs.push_back(make_ready(3));
+
+        auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+        EXPECT_EQ(task.get(), std::vector<Byte> { std::byte { 42 } }) << "lazy: " << lazy;
+    }
+}
+
+TEST_F(ReliableBroadcastTest, IgnoresValWithAnotherNodesProof)
+{
+    ReliableBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, 2));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+    EXPECT_TRUE(transport.broadcasts.empty());
+}
+
+namespace {
+    // An erasure code that, like the real one, needs K stripes to decode;
+    // records the K it was built and decoded with
+    struct ThresholdCryptoMock : CryptoMock {
+        std::vector<int> build_k;
+        std::vector<int> decode_k;
+
+        InlineTask<MockMerkleTree> async_build_merkle_tree(int K, int N, BytesSpan data)
+        {
+            build_k.push_back(K);
+            co_return co_await CryptoMock::async_build_merkle_tree(K, N, data);
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int K, int N, std::span<const ShardView> received_shards, const Hash& root)
+        {
+            decode_k.push_back(K);
+            if (std::cmp_less(received_shards.size(), K)) {
+                co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
+            co_return co_await CryptoMock::async_decode(K, N, received_shards, root);
+        }
+    };
+    static_assert(CryptoService<ThresholdCryptoMock>);
+} // namespace
+
+TEST_F(ReliableBroadcastTest, LeaderCodesWithNMinus2fDataShards)
+{
+    ThresholdCryptoMock threshold;
+    ReliableBroadcast<TransportMock, ThresholdCryptoMock> rbc(sys_ctx, Sid, Leader, Leader, transport, threshold);
+
+    auto task = rbc.run<InlineTask>(original_message, VectorStream {});
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+
+    EXPECT_EQ(threshold.build_k, std::vector<int> { N - (2 * f) });
+}
+
+TEST_F(ReliableBroadcastTest, DecodesFromTheNMinus2fStripesAReadyQuorumGuarantees)
+{
+    ThresholdCryptoMock threshold;
+    ReliableBroadcast<TransportMock, ThresholdCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, threshold);
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(2)); // N-2f stripes with our own
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_EQ(threshold.decode_k, std::vector<int> { N - (2 * f) });
+}
+
+TEST_F(ReliableBroadcastTest, FailedDecodeWaitsForMoreStripes)
+{
+    CountingCryptoMock counting;
+    counting.min_decode_shards = 3;
+    ReliableBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting);
+    VectorStream stream;
+    stream.msgs.push_back(make_val(Leader, MyPid));
+    stream.msgs.push_back(make_echo(0));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_ready(3));
+    stream.msgs.push_back(make_echo(2));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+}
+
+namespace {
+    // Crypto whose decodes stay pending until the test finishes them
+    struct DeferredDecodeCryptoMock : CryptoMock {
+        using DecodeResult = std::expected<std::vector<Byte>, std::error_code>;
+        struct Pending {
+            std::coroutine_handle<> handle;
+            std::size_t shards = 0;
+            DecodeResult result;
+        };
+        std::vector<std::shared_ptr<Pending>> decodes;
+
+        struct Awaiter {
+            std::shared_ptr<Pending> record;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) { record->handle = h; }
+            DecodeResult await_resume() { return std::move(record->result); }
+        };
+
+        Awaiter async_decode(int /*K*/, int /*N*/, std::span<const ShardView> received_shards, const Hash& /*root*/)
+        {
+            auto record = std::make_shared<Pending>();
+            record->shards = received_shards.size();
+            const BytesSpan first = received_shards.front().data;
+            record->result = std::vector<Byte>(first.begin(), first.end());
+            decodes.push_back(record);
+            return Awaiter { record };
+        }
+
+        void finish(std::size_t i, bool ok = true)
+        {
+            if (!ok)
+                decodes[i]->result = std::unexpected(std::make_error_code(std::errc::bad_message));
+            decodes[i]->handle.resume();
+        }
+    };
+    static_assert(CryptoService<DeferredDecodeCryptoMock>);
+
+    // Feeds messages one at a time on the test's command
+    struct ManualStream {
+        std::shared_ptr<AsyncInbox<std::optional<RBCMessage>>> inbox = std::make_shared<AsyncInbox<std::optional<RBCMessage>>>();
+
+        auto next() { return inbox->next(); }
+        void send(RBCMessage msg) { inbox->push(std::move(msg)); }
+        void close() { inbox->push(std::nullopt); }
+    };
+} // namespace
+
+TEST_F(ReliableBroadcastTest, SpeculativeDecodeStartsBeforeReadyQuorum)
+{
+    DeferredDecodeCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredDecodeCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .speculative_decode = true });
+    ManualStream stream;
+    auto task = rbc.run<InlineTask>(std::nullopt, stream);
+
+    stream.send(make_val(Leader, MyPid));
+    EXPECT_TRUE(deferred.decodes.empty());
+    // Our stripe and ECHO 0 are the N-2f needed
+    stream.send(make_echo(0));
+    ASSERT_EQ(deferred.decodes.size(), 1U);
+    EXPECT_EQ(deferred.decodes[0]->shards, 2U);
+
+    stream.send(make_echo(2));
+    stream.send(make_ready(0));
+    stream.send(make_ready(2));
+    stream.send(make_ready(3));
+    // The quorum waits for the decode already under way
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 1U);
+    EXPECT_EQ(deferred.decodes.size(), 1U);
+
+    deferred.finish(0);
+    EXPECT_EQ(task.get(), original_message);
+    stream.close();
+}
+
+TEST_F(ReliableBroadcastTest, SpeculativeDecodeWithLazyEchoesStartsBeforeReadyQuorum)
+{
+    DeferredDecodeCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredDecodeCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .lazy_echo_verification = true, .speculative_decode = true });
+    ManualStream stream;
+    auto task = rbc.run<InlineTask>(std::nullopt, stream);
+
+    stream.send(make_val(Leader, MyPid));
+    // ECHO 0 is checked on arrival, as it completes the N-2f stripes
+    stream.send(make_echo(0));
+    ASSERT_EQ(deferred.decodes.size(), 1U);
+    EXPECT_EQ(deferred.decodes[0]->shards, 2U);
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 0U);
+
+    stream.send(make_echo(2));
+    stream.send(make_ready(0));
+    stream.send(make_ready(2));
+    stream.send(make_ready(3));
+    EXPECT_EQ(deferred.decodes.size(), 1U);
+
+    deferred.finish(0);
+    EXPECT_EQ(task.get(), original_message);
+    stream.close();
+}
+
+TEST_F(ReliableBroadcastTest, SpeculativeDecodeResultWaitsForReadyQuorum)
+{
+    DeferredDecodeCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredDecodeCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .speculative_decode = true });
+    ManualStream stream;
+    auto task = rbc.run<InlineTask>(std::nullopt, stream);
+
+    stream.send(make_val(Leader, MyPid));
+    stream.send(make_echo(0));
+    ASSERT_EQ(deferred.decodes.size(), 1U);
+    deferred.finish(0);
+
+    stream.send(make_ready(0));
+    stream.send(make_ready(2));
+    stream.send(make_ready(3));
+    EXPECT_EQ(task.get(), original_message);
+    // Released from the cache, not decoded again
+    EXPECT_EQ(deferred.decodes.size(), 1U);
+    stream.close();
+}
+
+TEST_F(ReliableBroadcastTest, FailedSpeculativeDecodeIsRetriedWithMoreStripes)
+{
+    DeferredDecodeCryptoMock deferred;
+    ReliableBroadcast<TransportMock, DeferredDecodeCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, deferred,
+        { .speculative_decode = true });
+    ManualStream stream;
+    auto task = rbc.run<InlineTask>(std::nullopt, stream);
+
+    stream.send(make_val(Leader, MyPid));
+    stream.send(make_echo(0));
+    deferred.finish(0, false);
+    stream.send(make_echo(2));
+    stream.send(make_ready(0));
+    stream.send(make_ready(2));
+    stream.send(make_ready(3));
+
+    ASSERT_EQ(deferred.decodes.size(), 2U);
+    EXPECT_EQ(deferred.decodes[1]->shards, 3U);
+    deferred.finish(1);
+    EXPECT_EQ(task.get(), original_message);
+    stream.close();
+}
+
+namespace {
+    // Reads a channel until it ends, recording each sender
+    InlineTask<std::vector<int>> drain(RBCChannel channel)
+    {
+        std::vector<int> senders;
+        while (auto msg = co_await channel.next()) {
+            senders.push_back(msg->sender);
+        }
+        co_return senders;
+    }
+
+    RBCMessage ready_for(int session_id, int sender)
+    {
+        return RBCMessage { .sender = sender, .session_id = session_id, .payload = ReadyPayload {} };
+    }
+} // namespace
+
+TEST(RBCMuxTest, RoutesByEpochAndProposer)
+{
+    ManualStream inbound;
+    RBCMux<ManualStream> mux(4, inbound);
+    auto pump = mux.run<InlineTask>();
+    auto a = drain(mux.open({ .epoch = 0, .proposer = 0 }));
+    auto b = drain(mux.open({ .epoch = 0, .proposer = 3 }));
+    auto c = drain(mux.open({ .epoch = 1, .proposer = 0 }));
+
+    EXPECT_EQ(mux.session_id({ .epoch = 1, .proposer = 2 }), 6);
+    inbound.send(ready_for(mux.session_id({ .epoch = 0, .proposer = 0 }), 1));
+    inbound.send(ready_for(mux.session_id({ .epoch = 1, .proposer = 0 }), 2));
+    inbound.send(ready_for(mux.session_id({ .epoch = 0, .proposer = 3 }), 3));
+    inbound.send(ready_for(mux.session_id({ .epoch = 0, .proposer = 0 }), 2));
+    inbound.close();
+
+    pump.get();
+    EXPECT_EQ(a.get(), (std::vector<int> { 1, 2 }));
+    EXPECT_EQ(b.get(), (std::vector<int> { 3 }));
+    EXPECT_EQ(c.get(), (std::vector<int> { 2 }));
+    EXPECT_EQ(mux.dropped(), 0U);
+}
+
+TEST(RBCMuxTest, KeepsEarlyMessagesUntilOpened)
+{
+    ManualStream inbound;
+    RBCMux<ManualStream> mux(4, inbound);
+    auto pump = mux.run<InlineTask>();
+
+    const int sid = mux.session_id({ .epoch = 1, .proposer = 2 });
+    inbound.send(ready_for(sid, 0));
+    inbound.send(ready_for(sid, 3));
+    auto early = drain(mux.open({ .epoch = 1, .proposer = 2 }));
+    inbound.send(ready_for(sid, 1));
+    EXPECT_THROW((void)mux.open({ .epoch = 1, .proposer = 2 }), std::logic_error);
+
+    inbound.close();
+    EXPECT_EQ(early.get(), (std::vector<int> { 0, 3, 1 }));
+}
+
+TEST(RBCMuxTest, CapsWhatEachSenderQueuesBeforeOpen)
+{
+    using Mux = RBCMux<ManualStream>;
+    ManualStream inbound;
+    Mux mux(4, inbound);
+    auto pump = mux.run<InlineTask>();
+
+    // 3 floods an instance nobody opened yet; 0 sends a READY and an ECHO
+    const int sid = mux.session_id({ .epoch = 1, .proposer = 2 });
+    for (int i = 0; i < 100; ++i) {
+        inbound.send(ready_for(sid, 3));
+    }
+    inbound.send(ready_for(sid, 0));
+    inbound.send(RBCMessage { .sender = 0, .session_id = sid, .payload = EchoPayload {} });
+    inbound.send(ready_for(sid, 7)); // no such sender
+    EXPECT_EQ(mux.dropped(), 100U - Mux::early_per_kind + 1);
+
+    // Once opened, nothing is held back
+    auto early = drain(mux.open({ .epoch = 1, .proposer = 2 }));
+    inbound.send(ready_for(sid, 3));
+    inbound.close();
+    EXPECT_EQ(early.get(), (std::vector<int> { 3, 3, 0, 0, 3 }));
+    EXPECT_EQ(mux.dropped(), 100U - Mux::early_per_kind + 1);
+}
+
+TEST(RBCMuxTest, RetiresEpochsInBulkAndDropsStragglers)
+{
+    ManualStream inbound;
+    RBCMux<ManualStream> mux(4, inbound, 2);
+    auto pump = mux.run<InlineTask>();
+
+    std::vector<InlineTask<std::vector<int>>> epoch0;
+    for (int p = 0; p < 4; ++p) {
+        epoch0.push_back(drain(mux.open({ .epoch = 0, .proposer = p })));
+    }
+    // Epoch 2 is past the window, as is a malformed id
+    inbound.send(ready_for(mux.session_id({ .epoch = 2, .proposer = 0 }), 1));
+    inbound.send(ready_for(-1, 1));
+    EXPECT_EQ(mux.dropped(), 2U);
+    EXPECT_THROW((void)mux.open({ .epoch = 2, .proposer = 0 }), std::out_of_range);
+
+    inbound.send(ready_for(mux.session_id({ .epoch = 1, .proposer = 1 }), 3));
+    inbound.send(ready_for(mux.session_id({ .epoch = 0, .proposer = 1 }), 2));
+
+    // Every epoch-0 channel ends at once; epoch 1 now shares the ring with 2
+    mux.retire_before(1);
+    EXPECT_EQ(mux.oldest_epoch(), 1U);
+    for (int p = 0; p < 4; ++p) {
+        EXPECT_EQ(epoch0[p].get(), (p == 1 ? std::vector<int> { 2 } : std::vector<int> {}));
+    }
+    inbound.send(ready_for(mux.session_id({ .epoch = 0, .proposer = 1 }), 3));
+    EXPECT_EQ(mux.dropped(), 3U);
+
+    inbound.send(ready_for(mux.session_id({ .epoch = 2, .proposer = 1 }), 0));
+    auto late = drain(mux.open({ .epoch = 1, .proposer = 1 }));
+    auto next = drain(mux.open({ .epoch = 2, .proposer = 1 }));
+    inbound.close();
+    EXPECT_EQ(late.get(), (std::vector<int> { 3 }));
+    EXPECT_EQ(next.get(), (std::vector<int> { 0 }));
+}
+
+TEST_F(ReliableBroadcastTest, MuxFeedsSeveralInstancesFromOneStream)
+{
+    const SessionKey first { .epoch = 0, .proposer = Leader };
+    const SessionKey second { .epoch = 0, .proposer = 2 };
+    auto tagged = [](RBCMessage msg, int sid) {
+        msg.session_id = sid;
+        return msg;
+    };
+
+    // Both instances' messages interleaved on one stream
+    VectorStream inbound;
+    RBCMux<VectorStream> probe(N, VectorStream {}); // only to compute session ids
+    for (const SessionKey& key : { first, second }) {
+        inbound.msgs.push_back(tagged(make_val(key.proposer, MyPid), probe.session_id(key)));
+    }
+    for (int sender : { 0, 2, 3 }) {
+        for (const SessionKey& key : { first, second }) {
+            inbound.msgs.push_back(tagged(make_echo(sender), probe.session_id(key)));
+            inbound.msgs.push_back(tagged(make_ready(sender), probe.session_id(key)));
+        }
+    }
+
+    RBCMux<VectorStream> mux(N, std::move(inbound));
+    ReliableBroadcast<TransportMock, CryptoMock> a(sys_ctx, mux.session_id(first), MyPid, first.proposer, transport, crypto);
+    ReliableBroadcast<TransportMock, CryptoMock> b(sys_ctx, mux.session_id(second), MyPid, second.proposer, transport, crypto);
+    auto task_a = a.run<InlineTask>(std::nullopt, mux.open(first));
+    auto task_b = b.run<InlineTask>(std::nullopt, mux.open(second));
+
+    mux.run<InlineTask>().get();
+    EXPECT_EQ(task_a.get(), original_message);
+    EXPECT_EQ(task_b.get(), original_message);
+    EXPECT_EQ(mux.dropped(), 0U);
+    EXPECT_EQ(count_broadcasts_of_ready(transport), 2U);
+}
+
+namespace {
+    // Stripes starting with the poison byte fail their proof, and decoding
+    // fails if any is among the shards
+    constexpr std::byte Poison { 0xEE };
+    struct PoisonCryptoMock : CountingCryptoMock {
+        InlineTask<bool> async_verify_merkle(BytesSpan stripe, size_t proof_index, std::span<const Hash> merkle_path, const Hash& root)
+        {
+            const bool valid = co_await CountingCryptoMock::async_verify_merkle(stripe, proof_index, merkle_path, root);
+            co_return valid && (stripe.empty() || stripe.front() != Poison);
+        }
+
+        InlineTask<std::expected<std::vector<Byte>, std::error_code>> async_decode(
+            int K, int N, std::span<const ShardView> received_shards, const Hash& root)
+        {
+            for (const ShardView& shard : received_shards) {
+                if (!shard.data.empty() && shard.data.front() == Poison)
+                    co_return std::unexpected(std::make_error_code(std::errc::bad_message));
+            }
+            co_return co_await CryptoMock::async_decode(K, N, received_shards, root);
+        }
+    };
+    static_assert(CryptoService<PoisonCryptoMock>);
+} // namespace
+
+class HashEchoBroadcastTest : public ReliableBroadcastTest {
+protected:
+    RBCMessage make_echo_hash(int sender_id)
+    {
+        return RBCMessage {
+            .sender = sender_id,
+            .session_id = Sid,
+            .payload = EchoHashPayload { .root_hash = mock_root }
+        };
+    }
+
+    // Pushed stripes come without a proof; answers to PROOF_REQUEST with one
+    RBCMessage make_fragment(int sender_id, std::vector<Byte> stripe, bool proven = false)
+    {
+        MerklePath path;
+        if (proven)
+            path.push_back(mock_root);
+        return RBCMessage {
+            .sender = sender_id,
+            .session_id = Sid,
+            .payload = FragmentPayload {
+                .root_hash = mock_root,
+                .proof_index = static_cast<size_t>(sender_id),
+                .merkle_path = std::move(path),
+                .stripe = std::move(stripe) }
+        };
+    }
+    RBCMessage make_fragment(int sender_id, bool proven = false) { return make_fragment(sender_id, shards[sender_id], proven); }
+
+    RBCMessage make_proof_request(int sender_id)
+    {
+        return RBCMessage {
+            .sender = sender_id,
+            .session_id = Sid,
+            .payload = ProofRequestPayload { .root_hash = mock_root }
+        };
+    }
+
+    // VAL, then ECHOs from 0 and 2: with ours a quorum, so we send READY.
+    // 0 and 3 push their stripes to us.
+    void push_votes(VectorStream& stream)
+    {
+        stream.msgs.push_back(make_val(Leader, MyPid));
+        stream.msgs.push_back(make_echo_hash(0));
+        stream.msgs.push_back(make_echo_hash(2));
+    }
+
+    static bool asked_for_proofs(const TransportMock& transport)
+    {
+        return std::ranges::any_of(transport.broadcasts, [](const RBCMessage& msg) {
+            return std::holds_alternative<ProofRequestPayload>(msg.payload);
+        });
+    }
+};
+
+TEST_F(HashEchoBroadcastTest, DeliversFromHashVotesAndPushedStripes)
+{
+    CountingCryptoMock counting;
+    HashEchoBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting);
+    VectorStream stream;
+    push_votes(stream);
+    stream.msgs.push_back(make_fragment(0));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+
+    // Votes carry the root only
+    ASSERT_EQ(transport.broadcasts.size(), 2U);
+    EXPECT_TRUE(std::holds_alternative<EchoHashPayload>(transport.broadcasts[0].payload));
+    EXPECT_TRUE(std::holds_alternative<ReadyPayload>(transport.broadcasts[1].payload));
+    // Our stripe goes to the N-f-1 nodes after us, without its proof
+    ASSERT_EQ(transport.unicasts.size(), static_cast<std::size_t>(N - f - 1));
+    for (int i = 0; i < N - f - 1; ++i) {
+        EXPECT_EQ(transport.unicasts[i].target, MyPid + 1 + i);
+        const auto& fragment = std::get<FragmentPayload>(transport.unicasts[i].msg.payload);
+        EXPECT_EQ(fragment.proof_index, static_cast<size_t>(MyPid));
+        EXPECT_TRUE(fragment.merkle_path.empty());
+    }
+    // Only the VAL's proof was checked
+    EXPECT_EQ(counting.verified, (std::vector<size_t> { MyPid }));
+}
+
+TEST_F(HashEchoBroadcastTest, FallsBackToProvenStripesWhenDecodeFails)
+{
+    PoisonCryptoMock crypto;
+    HashEchoBroadcast<TransportMock, PoisonCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    push_votes(stream);
+    stream.msgs.push_back(make_fragment(0, { Poison }));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    // After the request, stripes count only with a valid proof
+    stream.msgs.push_back(make_fragment(0, { Poison }, true));
+    stream.msgs.push_back(make_fragment(3, true));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+
+    ASSERT_EQ(transport.broadcasts.size(), 3U);
+    EXPECT_TRUE(std::holds_alternative<ProofRequestPayload>(transport.broadcasts[2].payload));
+    EXPECT_EQ(crypto.verified, (std::vector<size_t> { MyPid, 0, 3 }));
+}
+
+TEST_F(HashEchoBroadcastTest, IgnoresFragmentsReplayedByAnotherPeer)
+{
+    PoisonCryptoMock crypto;
+    HashEchoBroadcast<TransportMock, PoisonCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    push_votes(stream);
+    stream.msgs.push_back(make_fragment(0, { Poison }));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    // 3 passes off 0's proven stripe as its own
+    RBCMessage replayed = make_fragment(0, true);
+    replayed.sender = 3;
+    stream.msgs.push_back(std::move(replayed));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+    EXPECT_EQ(crypto.verified, (std::vector<size_t> { MyPid }));
+}
+
+TEST_F(HashEchoBroadcastTest, FailedProvenDecodeWaitsForMoreStripes)
+{
+    CountingCryptoMock counting;
+    counting.min_decode_shards = 3;
+    HashEchoBroadcast<TransportMock, CountingCryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, counting);
+    VectorStream stream;
+    push_votes(stream);
+    stream.msgs.push_back(make_fragment(0));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    // Two proven stripes are not enough for this decoder; the third is
+    stream.msgs.push_back(make_fragment(0, true));
+    stream.msgs.push_back(make_fragment(3, true));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_TRUE(asked_for_proofs(transport));
+}
+
+TEST_F(HashEchoBroadcastTest, AsksForProofsWhenPushersHaveNoStripe)
+{
+    HashEchoBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    push_votes(stream);
+    // Both pushers sent READY without their stripe first
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(3));
+    stream.msgs.push_back(make_fragment(2, true));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+    EXPECT_TRUE(asked_for_proofs(transport));
+}
+
+TEST_F(HashEchoBroadcastTest, SendsReadyWithoutValAfterFPlus1Readies)
+{
+    HashEchoBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_THROW((void)task.get(), std::runtime_error);
+
+    // Our pushees learn from it that we have no stripe for them
+    ASSERT_EQ(transport.broadcasts.size(), 1U);
+    EXPECT_EQ(std::get<ReadyPayload>(transport.broadcasts[0].payload).root_hash, mock_root);
+    EXPECT_TRUE(transport.unicasts.empty());
+}
+
+TEST_F(HashEchoBroadcastTest, StopsReadingAtDeliveryAndServesLaterRequests)
+{
+    HashEchoBroadcast<TransportMock, CryptoMock> rbc(sys_ctx, Sid, MyPid, Leader, transport, crypto);
+    VectorStream stream;
+    stream.msgs.push_back(make_proof_request(3));
+    push_votes(stream);
+    std::get<ValPayload>(stream.msgs[1].payload).merkle_path.push_back(mock_root);
+    stream.msgs.push_back(make_fragment(0));
+    stream.msgs.push_back(make_ready(0));
+    stream.msgs.push_back(make_ready(2));
+    stream.msgs.push_back(make_proof_request(0));
+
+    auto task = rbc.run<InlineTask>(std::nullopt, std::move(stream));
+    EXPECT_EQ(task.get(), original_message);
+
+    const auto proofs_sent_to = [&] {
+        std::vector<NodeId> targets;
+        for (const auto& sent : transport.unicasts) {
+            if (!std::get<FragmentPayload>(sent.msg.payload).merkle_path.empty())
+                targets.push_back(sent.target);
+        }
+        return targets;
+    };
+    // 3 asked before we had a stripe; 0 after we delivered
+    EXPECT_EQ(proofs_sent_to(), std::vector<NodeId> { 3 });
+
+    VectorStream rest;
+    rest.msgs.push_back(make_proof_request(0));
+    rest.msgs.push_back(make_proof_request(3));
+    rest.msgs.push_back(make_proof_request(0));
+    rbc.serve<InlineTask>(std::move(rest)).get();
+    EXPECT_EQ(proofs_sent_to(), (std::vector<NodeId> { 3, 0 }));
+}
+
+namespace {
+    // Every node's messages in one FIFO queue, so each link keeps its order
+    struct LoopbackNetwork {
+        struct Transport {
+            LoopbackNetwork* net;
+            NodeId me;
+            bool poison_stripes = false; ///< a faulty node: every stripe it sends is bad
+
+            InlineTask<void> unicast(int target, const RBCMessage& msg)
+            {
+                net->send(me, target, msg, poison_stripes);
+                co_return;
+            }
+            InlineTask<void> broadcast(const RBCMessage& msg)
+            {
+                for (int i = 0; i < static_cast<int>(net->inboxes.size()); ++i) {
+                    if (i != me)
+                        net->send(me, i, msg, poison_stripes);
+                }
+                co_return;
+            }
+        };
+
+        explicit LoopbackNetwork(int N)
+            : proof_requests(N)
+        {
+            for (int i = 0; i < N; ++i) {
+                inboxes.push_back(std::make_shared<RBCChannel::Inbox>());
+                transports.push_back({ .net = this, .me = i });
+            }
+        }
+
+        void send(NodeId from, NodeId to, RBCMessage msg, bool poison)
+        {
+            if (auto* fragment = std::get_if<FragmentPayload>(&msg.payload)) {
+                ++fragments;
+                if (poison)
+                    fragment->stripe = std::vector<Byte> { Poison };
+            }
+            if (std::holds_alternative<ProofRequestPayload>(msg.payload))
+                proof_requests.insert(from);
+            queue.push_back({ to, std::move(msg) });
+        }
+
+        // Hands the oldest message in flight to its node; false if none is
+        bool deliver_one()
+        {
+            if (queue.empty())
+                return false;
+            auto [to, msg] = std::move(queue.front());
+            queue.pop_front();
+            inboxes[to]->push(std::move(msg));
+            return true;
+        }
+        void close()
+        {
+            for (const auto& inbox : inboxes) {
+                inbox->push(std::nullopt);
+            }
+        }
+
+        std::vector<std::shared_ptr<RBCChannel::Inbox>> inboxes;
+        std::vector<Transport> transports;
+        std::deque<std::pair<NodeId, RBCMessage>> queue;
+        std::size_t fragments = 0;
+        NodeSet proof_requests; ///< nodes that sent PROOF_REQUEST
+    };
+    static_assert(Transceiver<LoopbackNetwork::Transport>);
+} // namespace
+
+class HashEchoNetworkTest : public ReliableBroadcastTest {
+protected:
+    LoopbackNetwork net { N };
+    PoisonCryptoMock crypto;
+    std::vector<std::unique_ptr<HashEchoBroadcast<LoopbackNetwork::Transport, PoisonCryptoMock>>> nodes;
+
+    // Runs one broadcast from Leader to the end and returns every node's
+    // output. A node serves its proof once it has delivered, as an embedder
+    // should until it retires the instance.
+    std::vector<RBCOutput> broadcast()
+    {
+        std::vector<InlineTask<RBCOutput>> tasks;
+        for (int i = 0; i < N; ++i) {
+            nodes.push_back(std::make_unique<HashEchoBroadcast<LoopbackNetwork::Transport, PoisonCryptoMock>>(
+                sys_ctx, Sid, i, Leader, net.transports[i], crypto));
+            auto input = i == Leader ? std::optional(original_message) : std::nullopt;
+            tasks.push_back(nodes.back()->run<InlineTask>(std::move(input), RBCChannel(net.inboxes[i])));
+        }
+        std::vector<InlineTask<void>> serving;
+        NodeSet serves(N);
+        const auto serve_delivered = [&] {
+            for (int i = 0; i < N; ++i) {
+                if (tasks[i].done() && serves.insert(i))
+                    serving.push_back(nodes[i]->serve<InlineTask>(RBCChannel(net.inboxes[i])));
+            }
+        };
+        while (net.deliver_one()) {
+            serve_delivered();
+        }
+        net.close();
+
+        std::vector<RBCOutput> outputs;
+        for (auto& task : tasks) {
+            outputs.push_back(task.get());
+        }
+        return outputs;
+    }
+};
+
+TEST_F(HashEchoNetworkTest, HonestNodesPushEachStripeToNMinusFMinus1Peers)
+{
+    for (const RBCOutput& output : broadcast()) {
+        EXPECT_EQ(output, original_message);
+    }
+    EXPECT_EQ(net.fragments, static_cast<std::size_t>(N * (N - f - 1)));
+    EXPECT_TRUE(net.proof_requests.empty());
+}
+
+TEST_F(HashEchoNetworkTest, OneBadStripeSendsEveryNodeItReachesToProofs)
+{
+    constexpr NodeId Faulty = 3;
+    net.transports[Faulty].poison_stripes = true;
+
+    for (const RBCOutput& output : broadcast()) {
+        EXPECT_EQ(output, original_message);
+    }
+    // Faulty pushes to 0 and 1; both fail to decode and ask everyone
+    EXPECT_EQ(net.proof_requests.count(), N - f - 1);
+    EXPECT_TRUE(net.proof_requests.contains(0));
+    EXPECT_TRUE(net.proof_requests.contains(1));
+}
+
+namespace {
+    // Suspends until the test resumes it by hand, like a send awaiting the NIC
+    struct DeferredSend {
+        std::vector<std::coroutine_handle<>>* pending;
+        bool fail = false;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) const { pending->push_back(h); }
+        void await_resume() const
+        {
+            if (fail)
+                throw std::runtime_error("send failed");
+        }
+    };
+} // namespace
+
+TEST(WhenAllTest, StartsEveryOperandBeforeWaiting)
+{
+    std::vector<std::coroutine_handle<>> pending;
+    bool done = false;
+    // The closure must outlive the coroutine that reads its captures
+    auto body = [&]() -> InlineTask<void> {
+        std::vector<DeferredSend> sends(4, DeferredSend { .pending = &pending });
+        co_await when_all(std::move(sends));
+        done = true;
+    };
+    auto waiter = body();
+
+    // All four sends are in flight at once
+    ASSERT_EQ(pending.size(), 4U);
+    for (std::size_t i = pending.size(); i-- > 1;) {
+        pending[i].resume();
+        EXPECT_FALSE(done);
+    }
+    pending[0].resume();
+    EXPECT_TRUE(done);
+    waiter.get();
+}
+
+TEST(WhenAllTest, RethrowsAfterAllFinished)
+{
+    std::vector<std::coroutine_handle<>> pending;
+    bool resumed = false;
+    auto body = [&]() -> InlineTask<void> {
+        std::vector<DeferredSend> sends(3, DeferredSend { .pending = &pending });
+        sends[1].fail = true;
+        co_await when_all(std::move(sends));
+        resumed = true;
+    };
+    auto waiter = body();
+
+    ASSERT_EQ(pending.size(), 3U);
+    pending[1].resume();
+    pending[0].resume();
+    pending[2].resume();
+    EXPECT_FALSE(resumed);
+    EXPECT_THROW(waiter.get(), std::runtime_error);
+
+    // Nothing to wait for completes without suspending
+    auto empty = []() -> InlineTask<void> { co_await when_all(std::vector<DeferredSend> {}); }();
+    EXPECT_NO_THROW(empty.get());
+}
+
+TEST(SharedBufferTest, CopiesAndSlicesShareStorage)
+{
+    std::vector<Byte> bytes { std::byte { 1 }, std::byte { 2 }, std::byte { 3 }, std::byte { 4 } };
+    const Byte* raw = bytes.data();
+    const SharedBytes buffer(std::move(bytes));
+    EXPECT_EQ(buffer.data(), raw);
+    EXPECT_EQ(buffer.size(), 4U);
+
+    const SharedBytes copy = buffer; // NOLINT(performance-unnecessary-copy-initialization)
+    EXPECT_EQ(copy.data(), raw);
+    EXPECT_EQ(copy.storage(), buffer.storage());
+
+    const SharedBytes tail = buffer.slice(1, 3);
+    EXPECT_EQ(tail.data(), raw + 1);
+    EXPECT_EQ(tail.storage(), buffer.storage());
+    EXPECT_EQ(tail, SharedBytes({ std::byte { 2 }, std::byte { 3 }, std::byte { 4 } }));
+    EXPECT_TRUE(buffer.slice(4, 0).empty());
+    EXPECT_THROW((void)buffer.slice(2, 3), std::out_of_range);
+
+    // A borrowed view keeps its owner alive
+    auto owner = std::make_shared<std::vector<Byte>>(8, std::byte { 9 });
+    const SharedBytes view(BytesSpan { *owner }.subspan(2, 4), owner);
+    std::weak_ptr<std::vector<Byte>> weak = owner;
+    owner.reset();
+    EXPECT_FALSE(weak.expired());
+    EXPECT_EQ(view.size(), 4U);
+    EXPECT_EQ(view[0], std::byte { 9 });
+}
+
+TEST(RBCCoreTest, CountsFirstVotePerSender)
+{
+    RBCCore core({ .session_id = 0, .node_id = 1, .total_nodes = 4, .fault_tolerance = 1, .leader_id = 0 });
+    Hash root {};
+    std::ranges::fill(root, std::byte { 0xCC });
+    Hash other {};
+    std::ranges::fill(other, std::byte { 0xDD });
+    const std::vector<Byte> stripe { std::byte { 7 } };
+
+    core.observe_val(0, ValPayload { .root_hash = root, .proof_index = 1, .merkle_path = {}, .stripe = stripe });
+    EXPECT_EQ(core.count_shards(root), 1);
+
+    core.observe_echo(2, EchoPayload { .root_hash = root, .proof_index = 2, .merkle_path = {}, .stripe = stripe });
+    core.observe_echo(2, EchoPayload { .root_hash = root, .proof_index = 2, .merkle_path = {}, .stripe = stripe });
+    // A second vote for another root does not count either
+    core.observe_echo(2, EchoPayload { .root_hash = other, .proof_index = 2, .merkle_path = {}, .stripe = stripe });
+    core.observe_echo(3, EchoPayload { .root_hash = other, .proof_index = 3, .merkle_path = {}, .stripe = stripe });
+    // Out-of-range senders are ignored
+    core.observe_echo(4, EchoPayload { .root_hash = root, .proof_index = 4, .merkle_path = {}, .stripe = stripe });
+    core.observe_echo(-1, EchoPayload { .root_hash = root, .proof_index = 0, .merkle_path = {}, .stripe = stripe });
+
+    EXPECT_EQ(core.count_echo(root), 1);
+    EXPECT_EQ(core.count_echo(other), 1);
+    EXPECT_EQ(core.count_shards(root), 2);
+    EXPECT_FALSE(core.should_send_ready());
+
+    core.mark_echo_sent();
+    EXPECT_EQ(core.count_echo(root), 2);
+
+    core.observe_ready(3, ReadyPayload { .root_hash = root });
+    core.observe_ready(3, ReadyPayload { .root_hash = root });
+    EXPECT_EQ(core.count_ready(root), 1);
+    EXPECT_FALSE(core.should_send_ready());
+    core.observe_ready(2, ReadyPayload { .root_hash = root });
+    EXPECT_TRUE(core.should_send_ready());
+
+    core.mark_ready_sent();
+    EXPECT_EQ(core.count_ready(root), 3);
+    EXPECT_TRUE(core.can_output());
+
+    auto shards = core.get_shards();
+    ASSERT_EQ(shards.size(), 2U);
+    EXPECT_EQ(shards[0].index, 1);
+    EXPECT_EQ(shards[1].index, 2);
+    EXPECT_TRUE(std::ranges::equal(shards[1].data, stripe));
+    EXPECT_EQ(core.get_shard(1), stripe);
+}
+
+TEST(RBCCoreTest, ReadiesBeforeValAreKept)
+{
+    RBCCore core({ .session_id = 0, .node_id = 1, .total_nodes = 4, .fault_tolerance = 1, .leader_id = 0 });
+    Hash root {};
+    std::ranges::fill(root, std::byte { 0xCC });
+
+    core.observe_ready(2, ReadyPayload { .root_hash = root });
+    core.observe_ready(3, ReadyPayload { .root_hash = root });
+    EXPECT_EQ(core.count_ready(root), 2);
+    EXPECT_FALSE(core.should_send_ready());
+    EXPECT_THROW((void)core.get_shards(), std::runtime_error);
+
+    core.observe_val(0, ValPayload { .root_hash = root, .proof_index = 1, .merkle_path = {}, .stripe = {} });
+    EXPECT_TRUE(core.should_send_ready());
+}
+
+TEST(RBCCoreTest, CapsCandidateRootsUnderAFlood)
+{
+    constexpr int N = 16;
+    constexpr int f = 5;
+    RBCCore core({ .session_id = 0, .node_id = 1, .total_nodes = N, .fault_tolerance = f, .leader_id = 0 });
+    const auto distinct = [](int i) {
+        Hash root {};
+        root[0] = std::byte { 0xAA };
+        root[1] = static_cast<std::byte>(i);
+        return root;
+    };
+
+    // Every sender names a root of its own in both its ECHO and its READY
+    for (int sender = 0; sender < N; ++sender) {
+        core.observe_echo(sender, EchoPayload { .root_hash = distinct(2 * sender), .proof_index = static_cast<size_t>(sender), .merkle_path = {}, .stripe = {} });
+        core.observe_ready(sender, ReadyPayload { .root_hash = distinct((2 * sender) + 1) });
+    }
+    EXPECT_EQ(core.candidate_roots(), core.max_slots());
+    EXPECT_EQ(core.max_slots(), static_cast<std::size_t>((2 * f) + 1));
+
+    // The VAL's root still gets a slot, evicting sender 0's ECHO root.
+    // Senders whose votes were dropped or evicted may vote for it.
+    Hash root {};
+    std::ranges::fill(root, std::byte { 0xCC });
+    core.observe_val(0, ValPayload { .root_hash = root, .proof_index = 1, .merkle_path = {}, .stripe = std::vector<Byte> { std::byte { 7 } } });
+    EXPECT_EQ(core.candidate_roots(), core.max_slots());
+    EXPECT_EQ(core.count_shards(root), 1);
+    core.observe_echo(N - 1, EchoPayload { .root_hash = root, .proof_index = N - 1, .merkle_path = {}, .stripe = {} });
+    core.observe_ready(N - 1, ReadyPayload { .root_hash = root });
+    core.observe_echo(0, EchoPayload { .root_hash = root, .proof_index = 0, .merkle_path = {}, .stripe = {} });
+    EXPECT_EQ(core.count_echo(root), 2);
+    EXPECT_EQ(core.count_ready(root), 1);
+    // Its READY was for a root that kept its slot
+    core.observe_ready(0, ReadyPayload { .root_hash = root });
+    EXPECT_EQ(core.count_ready(root), 1);
+    EXPECT_EQ(core.count_ready(distinct(1)), 1);
+}
+
+TEST(RBCCoreTest, UnverifiedEchoesVoteButHoldNoShard)
+{
+    RBCCore core({ .session_id = 0, .node_id = 1, .total_nodes = 4, .fault_tolerance = 1, .leader_id = 0 });
+    Hash root {};
+    std::ranges::fill(root, std::byte { 0xCC });
+    const std::vector<Byte> stripe { std::byte { 7 } };
+
+    core.observe_val(0, ValPayload { .root_hash = root, .proof_index = 1, .merkle_path = {}, .stripe = stripe });
+    core.observe_unverified_echo(3, EchoPayload { .root_hash = root, .proof_index = 3, .merkle_path = { Hash {} }, .stripe = stripe });
+    core.observe_unverified_echo(2, EchoPayload { .root_hash = root, .proof_index = 2, .merkle_path = {}, .stripe = stripe });
+    core.observe_unverified_echo(2, EchoPayload { .root_hash = root, .proof_index = 2, .merkle_path = {}, .stripe = stripe });
+
+    EXPECT_EQ(core.count_echo(root), 2);
+    EXPECT_EQ(core.count_shards(root), 1);
+    EXPECT_EQ(core.count_unverified(root), 2);
+    EXPECT_EQ(core.missing_shards(), 1);
+
+    core.observe_ready(0, ReadyPayload { .root_hash = root });
+    core.observe_ready(2, ReadyPayload { .root_hash = root });
+    core.observe_ready(3, ReadyPayload { .root_hash = root });
+    EXPECT_FALSE(core.can_output());
+    EXPECT_TRUE(core.could_output());
+
+    const auto echoes = core.unverified_echoes();
+    ASSERT_EQ(echoes.size(), 2U);
+    EXPECT_EQ(echoes[0].sender, 2);
+    EXPECT_EQ(echoes[1].sender, 3);
+    EXPECT_EQ(echoes[1].merkle_path.size(), 1U);
+
+    core.reject_echo(2);
+    EXPECT_EQ(core.count_unverified(root), 1);
+    EXPECT_EQ(core.count_echo(root), 2); // the vote stands
+    core.accept_echo(3);
+    EXPECT_TRUE(core.can_output());
+    EXPECT_EQ(core.missing_shards(), 0);
+    EXPECT_EQ(core.count_unverified(root), 0);
+    ASSERT_EQ(core.get_shards().size(), 2U);
+    EXPECT_EQ(core.get_shards()[1].index, 3);
+}
+
+TEST(RBCCoreTest, KeepsOneUnprovenStripePerSenderForKnownRoots)
+{
+    constexpr int N = 16;
+    constexpr int f = 5;
+    RBCCore core({ .session_id = 0, .node_id = 1, .total_nodes = N, .fault_tolerance = f, .leader_id = 0 });
+    Hash root {};
+    std::ranges::fill(root, std::byte { 0xCC });
+    Hash echoed {};
+    std::ranges::fill(echoed, std::byte { 0xAA });
+    const auto stripe = [] { return SharedBytes(std::vector<Byte> { std::byte { 7 } }); };
+
+    // Before the VAL, only the root a sender echoed takes its stripe
+    core.observe_echo_vote(2, echoed);
+    core.observe_stripe(2, echoed, stripe(), false);
+    EXPECT_EQ(core.count_unverified(echoed), 1);
+
+    // A faulty sender floods stripes for roots nobody voted for
+    for (int i = 0; i < 64; ++i) {
+        Hash flood {};
+        flood[0] = static_cast<std::byte>(i);
+        core.observe_stripe(3, flood, stripe(), false);
+        core.observe_stripe(3, flood, stripe(), true);
+    }
+    EXPECT_EQ(core.candidate_roots(), 1U);
+
+    core.observe_val(0, ValPayload { .root_hash = root, .proof_index = 1, .merkle_path = {}, .stripe = stripe() });
+    core.observe_stripe(4, root, stripe(), false);
+    core.observe_stripe(4, root, stripe(), false);
+    // 2 spent its one unproven stripe on the root it echoed
+    core.observe_stripe(2, root, stripe(), false);
+    // The echoed root is not 5's, nor current
+    core.observe_stripe(5, echoed, stripe(), false);
+    EXPECT_EQ(core.count_unverified(root), 1);
+    EXPECT_EQ(core.count_unverified(echoed), 1);
+
+    // A proven stripe for the current root is still taken from anyone
+    core.observe_stripe(2, root, stripe(), true);
+    EXPECT_EQ(core.count_shards(root), 2);
+    EXPECT_EQ(core.candidate_roots(), 2U);
+}
+
 } // namespace Honey::BFT::RBC
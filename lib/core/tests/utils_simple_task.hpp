@@ -60,6 +60,10 @@ public:
         return Awaiter { handle_ };
     }
 
+    /// Whether the coroutine ran to completion; it may have suspended on a
+    /// stream that really waits.
+    [[nodiscard]] bool done() const noexcept { return !handle_ || handle_.done(); }
+
     T get()
     {
         if (handle_.promise().ep)
@@ -0,0 +1,525 @@
+#include "crypto/erasure_code.hpp"
+#include "crypto/merkle_tree.hpp"
+#include "crypto/shard_commitment.hpp"
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Honey::Crypto::ErasureCode {
+
+namespace {
+
+    // HoneyBadger 参数：f = (N-1)/3，任意 N-2f 个分片即可恢复
+    int data_shards_for(int N)
+    {
+        int f = (N - 1) / 3;
+        return N - (2 * f);
+    }
+
+    std::vector<Byte> random_payload(size_t len)
+    {
+        std::vector<Byte> res(len);
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<uint16_t> dist(0, 255);
+        for (auto& b : res) {
+            b = static_cast<Byte>(dist(rng));
+        }
+        return res;
+    }
+
+    // 丢弃前 f 个数据分片，保证解码必须走矩阵求逆路径
+    std::map<int, std::vector<Byte>> pick_with_erasures(
+        const std::vector<std::vector<Byte>>& shards, int K)
+    {
+        int N = static_cast<int>(shards.size());
+        int f = (N - 1) / 3;
+        std::map<int, std::vector<Byte>> received;
+        for (int i = f; i < N && static_cast<int>(received.size()) < K; ++i) {
+            received[i] = shards[i];
+        }
+        return received;
+    }
+
+    // 最小的固定线程池：调用线程也参与执行，threads=1 时退化为串行条带
+    class ThreadPool {
+    public:
+        explicit ThreadPool(int threads)
+        {
+            for (int t = 1; t < threads; ++t) {
+                workers_.emplace_back([this] { worker(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            wake_.notify_all();
+            for (auto& w : workers_) {
+                w.join();
+            }
+        }
+
+        void run(size_t count, const std::function<void(size_t)>& task)
+        {
+            {
+                std::lock_guard lock(mutex_);
+                task_ = &task;
+                count_ = count;
+                next_ = 0;
+                pending_ = workers_.size();
+                ++generation_;
+            }
+            wake_.notify_all();
+            drain();
+
+            std::unique_lock lock(mutex_);
+            done_.wait(lock, [&] { return pending_ == 0; });
+        }
+
+        ParallelFor executor()
+        {
+            return [this](size_t count, const std::function<void(size_t)>& task) { run(count, task); };
+        }
+
+    private:
+        void drain()
+        {
+            for (size_t i = next_++; i < count_; i = next_++) {
+                (*task_)(i);
+            }
+        }
+
+        void worker()
+        {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock lock(mutex_);
+                    wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                    if (stop_)
+                        return;
+                    seen = generation_;
+                }
+                drain();
+                {
+                    std::lock_guard lock(mutex_);
+                    if (--pending_ == 0)
+                        done_.notify_one();
+                }
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable wake_;
+        std::condition_variable done_;
+        const std::function<void(size_t)>* task_ = nullptr;
+        size_t count_ = 0;
+        std::atomic<size_t> next_ { 0 };
+        size_t pending_ = 0;
+        uint64_t generation_ = 0;
+        bool stop_ = false;
+    };
+
+    void apply_args(benchmark::internal::Benchmark* b)
+    {
+        b->ArgNames({ "N", "bytes" });
+        b->ArgsProduct({ { 16, 64, 128 }, { 64 << 10, 1 << 20 } });
+    }
+
+} // namespace
+
+void BM_Encode(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N);
+
+    for (auto _ : state) {
+        auto shards = encode(ctx, payload);
+        benchmark::DoNotOptimize(shards);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+void BM_EncodeToArena(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N);
+
+    for (auto _ : state) {
+        auto arena = encode_to_arena(ctx, payload);
+        benchmark::DoNotOptimize(arena);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 每次调用都重新生成柯西矩阵与编码表，对应旧实现的单次开销
+void BM_EncodeFreshContext(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(1));
+
+    for (auto _ : state) {
+        auto ctx = *Context::create(K, N, 0);
+        auto shards = encode(ctx, payload);
+        benchmark::DoNotOptimize(shards);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+void BM_Decode(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N);
+    auto received = pick_with_erasures(*encode(ctx, payload), K);
+
+    for (auto _ : state) {
+        auto decoded = decode(ctx, received);
+        benchmark::DoNotOptimize(decoded);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 禁用解码表缓存：每次调用都要求逆并初始化解码表
+void BM_DecodeUncached(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N, 0);
+    auto received = pick_with_erasures(*encode(ctx, payload), K);
+
+    for (auto _ : state) {
+        auto decoded = decode(ctx, received);
+        benchmark::DoNotOptimize(decoded);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 解码到预分配的调用方缓冲区；erasures=0 为系统码直通路径
+void BM_DecodeInto(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    const bool erasures = state.range(2) != 0;
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N);
+    auto shards = *encode(ctx, payload);
+    auto received = erasures ? pick_with_erasures(shards, K) : std::map<int, std::vector<Byte>> {};
+    if (!erasures) {
+        for (int i = 0; i < K; ++i)
+            received[i] = shards[i];
+    }
+
+    std::vector<ShardView> views;
+    for (const auto& [idx, shard] : received)
+        views.push_back({ .index = idx, .data = shard });
+    std::vector<Byte> output(max_decoded_size(ctx, shards[0].size()));
+
+    for (auto _ : state) {
+        auto len = decode(ctx, views, output);
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 丢弃前 missing 个数据分片，其余数据分片全部保留，再用校验分片补足 K 个
+void BM_DecodeMissing(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    const int missing = std::min({ static_cast<int>(state.range(2)), K, N - K });
+    auto payload = random_payload(state.range(1));
+    auto ctx = *Context::create(K, N);
+    auto shards = *encode(ctx, payload);
+
+    std::vector<ShardView> views;
+    for (int i = missing; i < K + missing; ++i)
+        views.push_back({ .index = i, .data = shards[i] });
+    std::vector<Byte> output(max_decoded_size(ctx, shards[0].size()));
+
+    for (auto _ : state) {
+        auto len = decode(ctx, views, output);
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+    state.counters["missing"] = missing;
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 大批量（8-32 MB）下按列条带并行编码
+void BM_EncodeParallel(benchmark::State& state)
+{
+    const int N = 64;
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(0));
+    auto ctx = *Context::create(K, N);
+    ThreadPool pool(static_cast<int>(state.range(1)));
+    auto parallel = pool.executor();
+
+    for (auto _ : state) {
+        auto arena = encode_to_arena(ctx, payload, parallel);
+        benchmark::DoNotOptimize(arena);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// 丢失 f 个数据分片时的条带并行解码
+void BM_DecodeParallel(benchmark::State& state)
+{
+    const int N = 64;
+    const int K = data_shards_for(N);
+    auto payload = random_payload(state.range(0));
+    auto ctx = *Context::create(K, N);
+    auto received = pick_with_erasures(*encode(ctx, payload), K);
+    ThreadPool pool(static_cast<int>(state.range(1)));
+    auto parallel = pool.executor();
+
+    std::vector<ShardView> views;
+    for (const auto& [idx, shard] : received)
+        views.push_back({ .index = idx, .data = shard });
+    std::vector<Byte> output(max_decoded_size(ctx, received.begin()->second.size()));
+
+    for (auto _ : state) {
+        auto len = decode(ctx, views, output, parallel);
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// 两种后端在 N=64/256/1024 下的对比；GF(2^8) 不支持 N > 255
+void BM_BackendEncode(benchmark::State& state)
+{
+    const auto backend = static_cast<Backend>(state.range(0));
+    const int N = static_cast<int>(state.range(1));
+    const int K = data_shards_for(N);
+    auto ctx = Context::create(K, N, backend);
+    if (!ctx) {
+        state.SkipWithError("unsupported N for this backend");
+        return;
+    }
+    auto payload = random_payload(state.range(2));
+
+    for (auto _ : state) {
+        auto arena = encode_to_arena(*ctx, payload);
+        benchmark::DoNotOptimize(arena);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(2));
+}
+
+void BM_BackendDecode(benchmark::State& state)
+{
+    const auto backend = static_cast<Backend>(state.range(0));
+    const int N = static_cast<int>(state.range(1));
+    const int K = data_shards_for(N);
+    auto ctx = Context::create(K, N, backend);
+    if (!ctx) {
+        state.SkipWithError("unsupported N for this backend");
+        return;
+    }
+    auto payload = random_payload(state.range(2));
+    auto received = pick_with_erasures(*encode(*ctx, payload), K);
+
+    std::vector<ShardView> views;
+    for (const auto& [idx, shard] : received)
+        views.push_back({ .index = idx, .data = shard });
+    std::vector<Byte> output(max_decoded_size(*ctx, received.begin()->second.size()));
+
+    for (auto _ : state) {
+        auto len = decode(*ctx, views, output);
+        benchmark::DoNotOptimize(len);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(2));
+}
+
+// 多个独立载荷：逐个 encode 与一次 encode_batch 对比
+std::vector<std::vector<Byte>> batch_payloads(const benchmark::State& state)
+{
+    std::vector<std::vector<Byte>> payloads(state.range(0));
+    for (auto& p : payloads)
+        p = random_payload(state.range(1));
+    return payloads;
+}
+
+void BM_EncodeLoop(benchmark::State& state)
+{
+    const int N = 64;
+    auto ctx = *Context::create(data_shards_for(N), N);
+    auto payloads = batch_payloads(state);
+
+    for (auto _ : state) {
+        for (const auto& p : payloads) {
+            auto shards = encode(ctx, p);
+            benchmark::DoNotOptimize(shards);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+void BM_EncodeBatch(benchmark::State& state)
+{
+    const int N = 64;
+    auto ctx = *Context::create(data_shards_for(N), N);
+    auto payloads = batch_payloads(state);
+    std::vector<BytesSpan> spans(payloads.begin(), payloads.end());
+
+    for (auto _ : state) {
+        auto arenas = encode_batch(ctx, spans);
+        benchmark::DoNotOptimize(arenas);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * state.range(1));
+}
+
+// RBC leader：先编码、再对分片建 Merkle 树并逐个生成证明（三遍访存）
+void BM_EncodeThenCommit(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    auto ctx = *Context::create(data_shards_for(N), N);
+    auto payload = random_payload(state.range(1));
+
+    for (auto _ : state) {
+        auto arena = *encode_to_arena(ctx, payload);
+        auto views = arena.views();
+        auto tree = MerkleTree::Tree::build(views, arena.storage());
+        std::vector<MerkleTree::Proof> proofs;
+        proofs.reserve(views.size());
+        for (size_t i = 0; i < views.size(); ++i)
+            proofs.push_back(*tree.prove(i));
+        benchmark::DoNotOptimize(proofs);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 同样的输出，但每个条带编码完立即在缓存中哈希
+void BM_EncodeAndCommit(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    auto ctx = *Context::create(data_shards_for(N), N);
+    auto payload = random_payload(state.range(1));
+
+    for (auto _ : state) {
+        auto committed = encode_and_commit(ctx, payload);
+        benchmark::DoNotOptimize(committed);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// RBC 接收方：丢弃前 f 个数据分片，解码后再完整编码、建树并比较根
+void BM_DecodeThenRecommit(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto ctx = *Context::create(K, N);
+    auto payload = random_payload(state.range(1));
+    auto committed = *encode_and_commit(ctx, payload);
+    const auto received = pick_with_erasures(*encode(ctx, payload), K);
+
+    std::vector<ShardView> views;
+    for (const auto& [idx, shard] : received)
+        views.push_back({ .index = idx, .data = shard });
+    std::vector<Byte> output(max_decoded_size(ctx, received.begin()->second.size()));
+
+    for (auto _ : state) {
+        auto len = decode(ctx, views, output);
+        auto arena = *encode_to_arena(ctx, BytesSpan(output).first(*len));
+        auto leaves = arena.views();
+        bool ok = MerkleTree::Tree::build(leaves, arena.storage()).root() == committed.tree.root();
+        benchmark::DoNotOptimize(ok);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+// 同样的检查，但只重新生成缺失的分片，并在条带仍在缓存中时哈希
+void BM_DecodeAndRecommit(benchmark::State& state)
+{
+    const int N = static_cast<int>(state.range(0));
+    const int K = data_shards_for(N);
+    auto ctx = *Context::create(K, N);
+    auto payload = random_payload(state.range(1));
+    auto committed = *encode_and_commit(ctx, payload);
+    const auto received = pick_with_erasures(*encode(ctx, payload), K);
+
+    std::vector<ShardView> views;
+    for (const auto& [idx, shard] : received)
+        views.push_back({ .index = idx, .data = shard });
+    std::vector<Byte> output(max_decoded_size(ctx, received.begin()->second.size()));
+
+    for (auto _ : state) {
+        auto len = decode_and_recommit(ctx, views, committed.tree.root(), output);
+        benchmark::DoNotOptimize(len);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(1));
+}
+
+void commit_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "N", "bytes" });
+    b->ArgsProduct({ { 16, 64, 128 }, { 64 << 10, 1 << 20, 8 << 20 } });
+}
+
+void batch_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "payloads", "bytes" });
+    b->ArgsProduct({ { 4, 16, 64 }, { 4 << 10, 64 << 10 } });
+}
+
+void backend_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "backend", "N", "bytes" });
+    b->ArgsProduct({ { static_cast<int64_t>(Backend::Gf8Cauchy), static_cast<int64_t>(Backend::Gf16Fft) },
+        { 64, 256, 1024 }, { 1 << 20 } });
+}
+
+BENCHMARK(BM_Encode)->Apply(apply_args);
+BENCHMARK(BM_EncodeToArena)->Apply(apply_args);
+BENCHMARK(BM_EncodeFreshContext)->Apply(apply_args);
+BENCHMARK(BM_Decode)->Apply(apply_args);
+BENCHMARK(BM_DecodeUncached)->Apply(apply_args);
+BENCHMARK(BM_DecodeInto)
+    ->ArgNames({ "N", "bytes", "erasures" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 64 << 10, 1 << 20 }, { 0, 1 } });
+BENCHMARK(BM_DecodeMissing)
+    ->ArgNames({ "N", "bytes", "missing" })
+    ->ArgsProduct({ { 64, 128 }, { 1 << 20 }, { 0, 1, 2, 4, 8, 16, 32 } });
+BENCHMARK(BM_EncodeLoop)->Apply(batch_args);
+BENCHMARK(BM_EncodeBatch)->Apply(batch_args);
+BENCHMARK(BM_EncodeThenCommit)->Apply(commit_args);
+BENCHMARK(BM_EncodeAndCommit)->Apply(commit_args);
+BENCHMARK(BM_DecodeThenRecommit)->Apply(commit_args);
+BENCHMARK(BM_DecodeAndRecommit)->Apply(commit_args);
+BENCHMARK(BM_BackendEncode)->Apply(backend_args);
+BENCHMARK(BM_BackendDecode)->Apply(backend_args);
+BENCHMARK(BM_EncodeParallel)
+    ->ArgNames({ "bytes", "threads" })
+    ->ArgsProduct({ { 8 << 20, 32 << 20 }, { 1, 2, 4, 8, 16 } })
+    ->UseRealTime();
+BENCHMARK(BM_DecodeParallel)
+    ->ArgNames({ "bytes", "threads" })
+    ->ArgsProduct({ { 8 << 20, 32 << 20 }, { 1, 2, 4, 8, 16 } })
+    ->UseRealTime();
+
+} // namespace Honey::Crypto::ErasureCode
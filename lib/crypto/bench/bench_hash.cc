@@ -0,0 +1,91 @@
+#include "crypto/common.hpp"
+#include <benchmark/benchmark.h>
+#include <openssl/evp.h>
+#include <vector>
+
+namespace Honey::Crypto {
+
+namespace {
+
+    std::vector<Byte> message(size_t len)
+    {
+        std::vector<Byte> res(len);
+        for (size_t i = 0; i < len; ++i) {
+            res[i] = static_cast<Byte>(i * 31);
+        }
+        return res;
+    }
+
+} // namespace
+
+// Previous Utils::sha256: EVP_Q_digest fetches "SHA256" by name on every call
+void BM_EvpQDigest(benchmark::State& state)
+{
+    auto msg = message(static_cast<size_t>(state.range(0)));
+    Hash256 hash {};
+    size_t len = 0;
+    for (auto _ : state) {
+        EVP_Q_digest(nullptr, "SHA256", nullptr, u8ptr(BytesSpan(msg)), msg.size(), u8ptr(hash.data()), &len);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.size()));
+}
+
+// Previous MerkleTree::verify: a fresh EVP_MD_CTX per call
+void BM_EvpNewCtx(benchmark::State& state)
+{
+    auto msg = message(static_cast<size_t>(state.range(0)));
+    Hash256 hash {};
+    for (auto _ : state) {
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+        EVP_DigestUpdate(ctx, msg.data(), msg.size());
+        EVP_DigestFinal_ex(ctx, u8ptr(hash.data()), nullptr);
+        EVP_MD_CTX_free(ctx);
+        benchmark::DoNotOptimize(hash);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.size()));
+}
+
+// Lower bound for OpenSSL: context and algorithm fetched once
+void BM_EvpReusedCtx(benchmark::State& state)
+{
+    auto msg = message(static_cast<size_t>(state.range(0)));
+    Hash256 hash {};
+    EVP_MD* md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    for (auto _ : state) {
+        EVP_DigestInit_ex(ctx, md, nullptr);
+        EVP_DigestUpdate(ctx, msg.data(), msg.size());
+        EVP_DigestFinal_ex(ctx, u8ptr(hash.data()), nullptr);
+        benchmark::DoNotOptimize(hash);
+    }
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_free(md);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.size()));
+}
+
+void BM_UtilsSha256(benchmark::State& state)
+{
+    auto msg = message(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Utils::sha256(msg));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * msg.size()));
+}
+
+// 32: ECDSA over a digest; 48: hashG over a compressed G1 point; 65: Merkle node
+void hash_sizes(benchmark::internal::Benchmark* b)
+{
+    b->ArgName("bytes");
+    for (int64_t len : { 32, 48, 65, 1024, 64 << 10 }) {
+        b->Arg(len);
+    }
+}
+
+BENCHMARK(BM_EvpQDigest)->Apply(hash_sizes);
+BENCHMARK(BM_EvpNewCtx)->Apply(hash_sizes);
+BENCHMARK(BM_EvpReusedCtx)->Apply(hash_sizes);
+BENCHMARK(BM_UtilsSha256)->Apply(hash_sizes);
+
+} // namespace Honey::Crypto
@@ -0,0 +1,313 @@
+#include "crypto/merkle_tree.hpp"
+#include "sha256_mb.hpp"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace Honey::Crypto::MerkleTree {
+
+namespace {
+
+    std::vector<std::vector<Byte>> random_leaves(size_t count, size_t len)
+    {
+        std::vector<std::vector<Byte>> leaves(count, std::vector<Byte>(len));
+        std::mt19937 rng(42);
+        for (auto& leaf : leaves) {
+            for (auto& b : leaf) {
+                b = static_cast<Byte>(rng());
+            }
+        }
+        return leaves;
+    }
+
+    std::vector<BytesSpan> views_of(const std::vector<std::vector<Byte>>& leaves)
+    {
+        return { leaves.begin(), leaves.end() };
+    }
+
+} // namespace
+
+// 一个 RBC 实例里每个节点对 N 个分片建树；分片大小即 block_size
+void BM_Build(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    const auto len = static_cast<size_t>(state.range(1));
+    auto leaves = random_leaves(N, len);
+    auto views = views_of(leaves);
+
+    for (auto _ : state) {
+        Tree tree = Tree::build(views, nullptr);
+        benchmark::DoNotOptimize(tree.root());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * len));
+}
+
+// 同样的叶子放在一块连续缓冲区里，树直接按条带切分，不再为叶子视图分配内存
+void BM_BuildStriped(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    const auto len = static_cast<size_t>(state.range(1));
+    std::vector<Byte> buffer;
+    for (const auto& leaf : random_leaves(N, len)) {
+        buffer.insert(buffer.end(), leaf.begin(), leaf.end());
+    }
+
+    for (auto _ : state) {
+        Tree tree = Tree::build(buffer, len, nullptr);
+        benchmark::DoNotOptimize(tree.root());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * len));
+}
+
+void BM_Verify(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    const auto len = static_cast<size_t>(state.range(1));
+    auto leaves = random_leaves(N, len);
+    Tree tree = Tree::build(views_of(leaves), nullptr);
+    auto proof = tree.prove(N / 2).value();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(verify(tree.leaf(N / 2), proof, tree.root()));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * len));
+}
+
+// 一个 RBC 实例中每个节点要对同一个根验证 N 条 ECHO 证明
+struct ProofSet {
+    std::vector<std::vector<Byte>> leaves;
+    std::vector<BytesSpan> views;
+    std::vector<Proof> proofs;
+    Hash root;
+};
+
+ProofSet proof_set(size_t N, size_t len)
+{
+    ProofSet set;
+    set.leaves = random_leaves(N, len);
+    set.views = views_of(set.leaves);
+    Tree tree = Tree::build(set.views, nullptr);
+    for (size_t i = 0; i < N; ++i) {
+        set.proofs.push_back(tree.prove(i).value());
+    }
+    set.root = tree.root();
+    return set;
+}
+
+void BM_VerifyEachProof(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    auto set = proof_set(N, static_cast<size_t>(state.range(1)));
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < N; ++i) {
+            benchmark::DoNotOptimize(verify(set.views[i], set.proofs[i], set.root));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * N));
+}
+
+// 证明逐条到达，但共享一个按根缓存已认证节点的校验器
+void BM_BatchVerifierEach(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    auto set = proof_set(N, static_cast<size_t>(state.range(1)));
+
+    for (auto _ : state) {
+        BatchVerifier verifier(set.root);
+        for (size_t i = 0; i < N; ++i) {
+            benchmark::DoNotOptimize(verifier.verify(set.views[i], set.proofs[i]));
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * N));
+}
+
+// 一次性提交全部证明，叶子哈希走多路内核
+void BM_BatchVerifierBulk(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    auto set = proof_set(N, static_cast<size_t>(state.range(1)));
+    auto results = std::make_unique<bool[]>(N);
+
+    for (auto _ : state) {
+        BatchVerifier verifier(set.root);
+        verifier.verify(set.views, set.proofs, std::span(results.get(), N));
+        benchmark::DoNotOptimize(results.get());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * N));
+}
+
+// 从 N=128 的树中取 k 个均匀分布的条带：k 条单独证明 vs 一条多叶证明
+struct SubsetFixture {
+    std::vector<std::vector<Byte>> leaves;
+    Tree tree;
+    std::vector<size_t> indices;
+    std::vector<BytesSpan> chosen;
+};
+
+SubsetFixture subset_fixture(size_t k, size_t len)
+{
+    constexpr size_t N = 128;
+    SubsetFixture f;
+    f.leaves = random_leaves(N, len);
+    f.tree = Tree::build(views_of(f.leaves), nullptr);
+    for (size_t i = 0; i < k; ++i) {
+        f.indices.push_back(i * N / k);
+        f.chosen.push_back(f.tree.leaf(f.indices.back()));
+    }
+    return f;
+}
+
+void BM_SingleProofs(benchmark::State& state)
+{
+    auto f = subset_fixture(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    std::vector<Proof> proofs;
+    size_t sibling_count = 0;
+    for (size_t idx : f.indices) {
+        proofs.push_back(f.tree.prove(idx).value());
+        sibling_count += proofs.back().siblings.size();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < proofs.size(); ++i) {
+            benchmark::DoNotOptimize(verify(f.chosen[i], proofs[i], f.tree.root()));
+        }
+    }
+    state.counters["siblings"] = static_cast<double>(sibling_count);
+}
+
+void BM_MultiProof(benchmark::State& state)
+{
+    auto f = subset_fixture(static_cast<size_t>(state.range(0)), static_cast<size_t>(state.range(1)));
+    auto proof = f.tree.prove(std::span<const size_t>(f.indices)).value();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(verify(f.chosen, proof, f.tree.root()));
+    }
+    state.counters["siblings"] = static_cast<double>(proof.siblings.size());
+}
+
+// 不同分叉数：宽节点让树更浅、哈希调用更少，代价是每层多带 Arity-2 个兄弟
+template <size_t Arity>
+void BM_ArityBuild(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    const auto len = static_cast<size_t>(state.range(1));
+    auto leaves = random_leaves(N, len);
+    auto views = views_of(leaves);
+
+    for (auto _ : state) {
+        auto tree = BasicTree<Arity>::build(views, nullptr);
+        benchmark::DoNotOptimize(tree.root());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * N));
+}
+
+template <size_t Arity>
+void BM_ArityProve(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    auto leaves = random_leaves(N, static_cast<size_t>(state.range(1)));
+    auto tree = BasicTree<Arity>::build(views_of(leaves), nullptr);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.prove(i));
+        i = (i + 1) % N;
+    }
+    state.counters["proof_bytes"] = static_cast<double>(tree.prove(0).value().siblings.size() * sizeof(Hash));
+}
+
+template <size_t Arity>
+void BM_ArityVerify(benchmark::State& state)
+{
+    const auto N = static_cast<size_t>(state.range(0));
+    auto leaves = random_leaves(N, static_cast<size_t>(state.range(1)));
+    auto tree = BasicTree<Arity>::build(views_of(leaves), nullptr);
+    std::vector<BasicProof<Arity>> proofs;
+    for (size_t i = 0; i < N; ++i) {
+        proofs.push_back(tree.prove(i).value());
+    }
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(verify<Arity>(tree.leaf(i), proofs[i], tree.root()));
+        i = (i + 1) % N;
+    }
+    state.counters["proof_bytes"] = static_cast<double>(proofs[0].siblings.size() * sizeof(Hash));
+}
+
+void arity_args(benchmark::internal::Benchmark* b)
+{
+    b->ArgNames({ "N", "bytes" });
+    b->ArgsProduct({ { 64, 128, 256, 512, 1024 }, { 64, 1 << 10 } });
+}
+
+// 同一组叶子分别走各个压缩内核，对比多缓冲与单缓冲的吞吐
+void BM_LeafKernel(benchmark::State& state)
+{
+    const auto kernel = static_cast<impl::Sha256Kernel>(state.range(0));
+    const auto N = static_cast<size_t>(state.range(1));
+    const auto len = static_cast<size_t>(state.range(2));
+    if (!impl::sha256_kernel_supported(kernel)) {
+        state.SkipWithError("kernel not supported on this CPU");
+        return;
+    }
+    state.SetLabel(std::string(impl::sha256_kernel_name(kernel)));
+
+    auto leaves = random_leaves(N, len);
+    std::vector<Hash> digests(N);
+    std::vector<impl::Sha256Job> jobs;
+    for (size_t i = 0; i < N; ++i) {
+        jobs.push_back({ .parts = { leaves[i], {}, {} }, .digest = digests[i].data() });
+    }
+
+    for (auto _ : state) {
+        impl::sha256_many(jobs, kernel);
+        benchmark::DoNotOptimize(digests.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * len));
+}
+
+BENCHMARK(BM_Build)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 1 << 10, 16 << 10, 64 << 10 } });
+BENCHMARK(BM_BuildStriped)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 1 << 10, 16 << 10, 64 << 10 } });
+BENCHMARK(BM_Verify)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 128 }, { 1 << 10, 64 << 10 } });
+BENCHMARK(BM_VerifyEachProof)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 64, 1 << 10, 16 << 10 } });
+BENCHMARK(BM_BatchVerifierEach)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 64, 1 << 10, 16 << 10 } });
+BENCHMARK(BM_BatchVerifierBulk)
+    ->ArgNames({ "N", "bytes" })
+    ->ArgsProduct({ { 16, 64, 128 }, { 64, 1 << 10, 16 << 10 } });
+BENCHMARK(BM_SingleProofs)
+    ->ArgNames({ "k", "bytes" })
+    ->ArgsProduct({ { 2, 8, 32, 43 }, { 64, 1 << 10 } });
+BENCHMARK(BM_MultiProof)
+    ->ArgNames({ "k", "bytes" })
+    ->ArgsProduct({ { 2, 8, 32, 43 }, { 64, 1 << 10 } });
+BENCHMARK_TEMPLATE(BM_ArityBuild, 2)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityBuild, 4)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityBuild, 8)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityBuild, 16)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityProve, 2)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityProve, 4)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityProve, 8)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityProve, 16)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityVerify, 2)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityVerify, 4)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityVerify, 8)->Apply(arity_args);
+BENCHMARK_TEMPLATE(BM_ArityVerify, 16)->Apply(arity_args);
+BENCHMARK(BM_LeafKernel)
+    ->ArgNames({ "kernel", "N", "bytes" })
+    ->ArgsProduct({ { 0, 1, 2, 3, 4 }, { 64 }, { 1 << 10, 16 << 10 } });
+
+} // namespace Honey::Crypto::MerkleTree
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <expected>
+#include <functional>
 #include <map>
+#include <memory>
+#include <span>
 #include <system_error>
 #include <vector>
 
@@ -9,49 +14,235 @@
 
 namespace Honey::Crypto::ErasureCode {
 
+/// Number of inverted decode tables a Context keeps by default.
+constexpr std::size_t DEFAULT_DECODE_CACHE_CAPACITY = 16;
+
+class DecodeTableCache;
+class Gf16Codec;
+
+/// Field and transform a Context encodes with. Shards are not interchangeable
+/// between backends.
+enum class Backend : std::uint8_t {
+    /// ISA-L Cauchy matrix over GF(2^8): N <= 255, O(K * (N-K)) work per byte.
+    Gf8Cauchy,
+    /// Additive-FFT Reed-Solomon over GF(2^16) (Leopard-style): O(n log n) work
+    /// per symbol, N up to tens of thousands. Shard sizes are always even.
+    Gf16Fft,
+};
+
+/**
+ * @brief Caller-supplied executor for striped encode/decode.
+ *
+ * Must invoke `task(i)` once for every i in [0, count), possibly concurrently,
+ * and return only after all of them finished. An empty ParallelFor runs the
+ * whole block range on the calling thread.
+ */
+using ParallelFor = std::function<void(std::size_t count, const std::function<void(std::size_t)>& task)>;
+
 class Context {
 public:
+    /**
+     * @brief Builds the Cauchy encode matrix and parity tables for a (K, N) code.
+     *
+     * Decode tables are derived from the encode matrix on demand and kept in a
+     * per-Context LRU cache keyed by the set of shard indices used for recovery.
+     * A capacity of zero disables the cache.
+     */
     [[nodiscard]]
-    static std::expected<Context, std::error_code> create(int K, int N);
+    static std::expected<Context, std::error_code> create(int K, int N,
+        std::size_t decode_cache_capacity = DEFAULT_DECODE_CACHE_CAPACITY);
+
+    /**
+     * @brief Builds a (K, N) code on the given backend.
+     *
+     * `Gf16Fft` needs no matrices or decode tables; it accepts any N with
+     * bit_ceil(N-K) + K <= 65536 and ignores `decode_cache_capacity`.
+     */
+    [[nodiscard]]
+    static std::expected<Context, std::error_code> create(int K, int N, Backend backend,
+        std::size_t decode_cache_capacity = DEFAULT_DECODE_CACHE_CAPACITY);
 
     Context(const Context&) = delete;
     Context& operator=(const Context&) = delete;
 
-    Context(Context&&) noexcept = default;
-    Context& operator=(Context&&) noexcept = default;
+    Context(Context&&) noexcept;
+    Context& operator=(Context&&) noexcept;
 
-    ~Context() = default;
+    ~Context();
 
     [[nodiscard]] int K() const noexcept { return K_; }
     [[nodiscard]] int N() const noexcept { return N_; }
+    [[nodiscard]] Backend backend() const noexcept;
+
+    /// Number of decode tables currently held by the cache.
+    [[nodiscard]] std::size_t cached_decode_tables() const noexcept;
 
 private:
     int K_;
     int N_;
     std::vector<unsigned char> encode_matrix_;
     std::vector<unsigned char> parity_g_tbls_;
-    std::vector<unsigned char> decode_g_tbls_;
+    std::unique_ptr<DecodeTableCache> decode_cache_;
+    std::unique_ptr<Gf16Codec> fft_codec_;
 
     Context(int K, int N, std::vector<unsigned char>&& encode_matrix,
         std::vector<unsigned char>&& parity_g_tbls,
-        std::vector<unsigned char>&& decode_g_tbls)
-        : K_(K)
-        , N_(N)
-        , encode_matrix_(std::move(encode_matrix))
-        , parity_g_tbls_(std::move(parity_g_tbls))
-        , decode_g_tbls_(std::move(decode_g_tbls))
+        std::unique_ptr<DecodeTableCache>&& decode_cache);
+
+    friend class ErasureCodeImpl;
+};
+
+/// Alignment of every shard inside a ShardArena.
+constexpr std::size_t SHARD_ALIGNMENT = 64;
+
+/**
+ * @brief Data and parity shards of one encoded payload in a single allocation.
+ *
+ * Shard i occupies `block_size()` bytes starting `i * stride()` bytes after
+ * the first shard, and each shard starts on a SHARD_ALIGNMENT boundary. The
+ * arenas returned by `encode_batch` interleave several payloads, so stride()
+ * may exceed the aligned block size. The
+ * length prefix is written in place at the start of shard 0. Copies share the
+ * same storage, so views handed out stay valid as long as any copy (or the
+ * `storage()` handle) is alive.
+ */
+class ShardArena {
+public:
+    ShardArena() = default;
+
+    [[nodiscard]] int size() const noexcept { return count_; }
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
+    [[nodiscard]] std::size_t block_size() const noexcept { return block_size_; }
+    [[nodiscard]] std::size_t stride() const noexcept { return stride_; }
+
+    [[nodiscard]] BytesSpan operator[](int index) const noexcept
     {
+        return { base_ + (static_cast<std::size_t>(index) * stride_), block_size_ };
     }
 
+    /// One span per shard, in index order.
+    [[nodiscard]] std::vector<BytesSpan> views() const;
+
+    /// Ownership handle for the underlying bytes.
+    [[nodiscard]] std::shared_ptr<const void> storage() const noexcept { return storage_; }
+
+private:
+    std::shared_ptr<Byte[]> storage_;
+    Byte* base_ = nullptr;
+    std::size_t block_size_ = 0;
+    std::size_t stride_ = 0;
+    int count_ = 0;
+
     friend class ErasureCodeImpl;
 };
 
+/**
+ * @brief Encodes `data` into one contiguous ShardArena.
+ *
+ * Unlike `encode`, the payload is copied exactly once (into the data shards)
+ * and parity is written next to it, without a staging buffer or per-shard
+ * allocations.
+ *
+ * With a `parallel` executor the shards are split into cache-sized column
+ * stripes that are encoded independently; the output is byte-identical to
+ * the serial path.
+ */
+[[nodiscard]]
+auto encode_to_arena(const Context& ctx, BytesSpan data, const ParallelFor& parallel = {})
+    -> std::expected<ShardArena, std::error_code>;
+
+/**
+ * @brief Receives each column stripe of `encode_streaming` once it is final.
+ *
+ * Columns [offset, offset + len) of all N shards of `arena` are written when
+ * it runs. Stripes arrive once each, in ascending order, on the calling
+ * thread, and are sized so that one stripe of every shard fits in L2.
+ */
+using StripeSink = std::function<void(const ShardArena& arena, std::size_t offset, std::size_t len)>;
+
+/**
+ * @brief Serial `encode_to_arena` that hands each stripe to `sink` while it
+ * is still in cache.
+ *
+ * Each stripe is copied in, encoded and passed on before the next one is
+ * touched, so a consumer such as a hasher reads it from L2 rather than
+ * memory. The shards are byte-identical to `encode_to_arena`.
+ */
+[[nodiscard]]
+auto encode_streaming(const Context& ctx, BytesSpan data, const StripeSink& sink)
+    -> std::expected<ShardArena, std::error_code>;
+
+/**
+ * @brief Encodes several independent payloads in a single pass.
+ *
+ * All payloads share a single allocation: shard i of every payload lives in
+ * row i, one aligned region per payload, and the whole row is encoded in one
+ * go. Each returned ShardArena is a view of its payload's regions; its shards
+ * are identical to what `encode_to_arena` produces for that payload alone.
+ */
+[[nodiscard]]
+auto encode_batch(const Context& ctx, std::span<const BytesSpan> payloads, const ParallelFor& parallel = {})
+    -> std::expected<std::vector<ShardArena>, std::error_code>;
+
 [[nodiscard]]
-auto encode(const Context& ctx, BytesSpan data)
+auto encode(const Context& ctx, BytesSpan data, const ParallelFor& parallel = {})
     -> std::expected<std::vector<std::vector<Byte>>, std::error_code>;
 
 [[nodiscard]]
-auto decode(const Context& ctx, const std::map<int, std::vector<Byte>>& received_shards)
+auto decode(const Context& ctx, const std::map<int, std::vector<Byte>>& received_shards,
+    const ParallelFor& parallel = {})
     -> std::expected<std::vector<Byte>, std::error_code>;
 
+/// A received shard: its index in [0, N) and a borrowed view of its bytes.
+struct ShardView {
+    int index;
+    BytesSpan data;
+};
+
+/// Largest payload that shards of `block_size` bytes can carry.
+[[nodiscard]]
+std::size_t max_decoded_size(const Context& ctx, std::size_t block_size) noexcept;
+
+/**
+ * @brief Recovers the payload directly into `output` and returns its length.
+ *
+ * Shards may arrive in any order; duplicates are ignored. When every data
+ * shard is present the payload is copied straight from them into `output`.
+ * Fails with `no_buffer_space` if `output` is shorter than the payload;
+ * `max_decoded_size` is always large enough.
+ */
+[[nodiscard]]
+auto decode(const Context& ctx, std::span<const ShardView> shards, MutableBytesSpan output,
+    const ParallelFor& parallel = {})
+    -> std::expected<std::size_t, std::error_code>;
+
+/**
+ * @brief Receives each column stripe of `reencode_streaming` once it is final.
+ *
+ * `shards` holds all N shards in index order. Only columns
+ * [offset, offset + len) of the regenerated ones are written when it runs.
+ * Stripes arrive once each, in ascending order, on the calling thread.
+ */
+using ShardsStripeSink = std::function<void(std::span<const BytesSpan> shards, std::size_t offset, std::size_t len)>;
+
+/**
+ * @brief `decode` that also regenerates every shard it did not decode from.
+ *
+ * The shards decoding starts from are passed through as received. Missing
+ * data blocks are recovered with the (cached) decode tables and the other
+ * parity shards are re-encoded from the data blocks with the Context's
+ * parity tables, one cache-sized column stripe at a time, each handed to
+ * `sink` before the next one is touched. The N shards seen by the sink thus
+ * form the codeword of the decoded data blocks, for about the work of one
+ * encode. Received shards that decoding did not use are not trusted and are
+ * regenerated like missing ones. On the Gf16Fft backend every parity shard
+ * is regenerated, as the transform yields them all at once.
+ *
+ * Fails like `decode`.
+ */
+[[nodiscard]]
+auto reencode_streaming(const Context& ctx, std::span<const ShardView> shards, MutableBytesSpan output,
+    const ShardsStripeSink& sink)
+    -> std::expected<std::size_t, std::error_code>;
+
 } // namespace Honey::Crypto::ErasureCode
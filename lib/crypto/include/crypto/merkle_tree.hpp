@@ -1,11 +1,19 @@
 #pragma once
 
 #include "crypto/common.hpp"
+#include "common/inline_vector.hpp"
+#include <algorithm>
 #include <array>
+#include <compare>
 #include <cstddef>
 #include <expected>
+#include <iterator>
+#include <memory>
+#include <mutex>
 #include <ranges>
+#include <span>
 #include <system_error>
+#include <unordered_map>
 #include <vector>
 
 namespace Honey::Crypto::MerkleTree {
@@ -14,46 +22,368 @@ constexpr std::int8_t SHA256_BYTES = 32;
 using SHA256Hash = std::array<std::byte, SHA256_BYTES>;
 using Hash = SHA256Hash;
 
-struct Proof {
+/// Largest leaf count a single-leaf Proof is sized for.
+constexpr std::size_t MAX_PROOF_LEAVES = 1024;
+
+/// Siblings on one leaf's path in a tree of `leaves` leaves and the given arity.
+[[nodiscard]] constexpr std::size_t proof_siblings(std::size_t arity, std::size_t leaves) noexcept
+{
+    std::size_t depth = 0;
+    for (std::size_t padded = 1; padded < leaves; padded *= arity) {
+        ++depth;
+    }
+    return depth * (arity - 1);
+}
+
+/// Capacity of BasicProof<Arity>::siblings: the longest path over
+/// MAX_PROOF_LEAVES leaves at that arity.
+template <std::size_t Arity>
+constexpr std::size_t MAX_PROOF_SIBLINGS = proof_siblings(Arity, MAX_PROOF_LEAVES);
+
+/**
+ * @brief Path from one leaf to the root of a `BasicTree<Arity>`.
+ *
+ * Each level contributes the `Arity - 1` other children of the node on the
+ * path, left to right, so a binary proof has one sibling per level. The
+ * siblings are stored inline, in room for the longest path at this arity
+ * only, so a proof never allocates and a binary one stays small.
+ */
+template <std::size_t Arity>
+struct BasicProof {
     size_t leaf_index;
+    InlineVector<Hash, MAX_PROOF_SIBLINGS<Arity>> siblings;
+};
+
+using Proof = BasicProof<2>;
+
+/**
+ * @brief Proof for several leaves of one tree.
+ *
+ * Carries only the siblings that cannot be computed from the proven leaves
+ * themselves: shared upper nodes appear once, and a node whose children
+ * are all proven costs nothing. Siblings are ordered level by level from
+ * the leaves up, left to right within a level.
+ */
+struct MultiProof {
+    size_t depth; ///< levels below the root, log_Arity of the padded leaf count
+    std::vector<size_t> leaf_indices; ///< strictly ascending
     std::vector<Hash> siblings;
 };
 
-class Tree {
+/**
+ * @brief Merkle tree whose internal nodes have `Arity` children.
+ *
+ * Leaves hash as SHA-256(0x00 || leaf) and internal nodes as
+ * SHA-256(0x01 || child_0 || ... || child_{Arity-1}); the leaf count is
+ * padded to a power of `Arity` with the hash of the empty leaf. Wider
+ * nodes give shallower trees and fewer, larger hash calls at the cost of
+ * `Arity - 1` siblings per proof level. `Tree` is the binary tree.
+ *
+ * Instantiated for arity 2, 4, 8 and 16.
+ */
+template <std::size_t Arity>
+class BasicTree {
+    static_assert(Arity >= 2, "a Merkle node needs at least two children");
+
 public:
-    using value_type = std::vector<Byte>;
-    using reference = const std::vector<Byte>&;
-    using const_reference = const std::vector<Byte>&;
-    using iterator = std::vector<std::vector<Byte>>::const_iterator;
-    using const_iterator = std::vector<std::vector<Byte>>::const_iterator;
-    using size_type = std::vector<std::vector<Byte>>::size_type;
+    class const_iterator;
+
+    static constexpr std::size_t arity = Arity;
 
-    Tree() = default;
+    using value_type = BytesSpan;
+    using reference = BytesSpan;
+    using const_reference = BytesSpan;
+    using iterator = const_iterator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    BasicTree() = default;
+
+    [[nodiscard]]
+    static BasicTree build(std::vector<std::vector<Byte>>&& leaves);
+
+    /**
+     * @brief Builds a tree over borrowed leaves without copying them.
+     *
+     * `owner` keeps the viewed bytes alive for the lifetime of the tree, e.g.
+     * `ErasureCode::ShardArena::storage()`. It may be null when the caller
+     * guarantees the leaves outlive the tree.
+     */
+    [[nodiscard]]
+    static BasicTree build(std::span<const BytesSpan> leaves, std::shared_ptr<const void> owner);
+
+    /**
+     * @brief Builds a tree whose leaves are equal-sized stripes of one buffer.
+     *
+     * Leaf i is `buffer.subspan(i * stride, stripe_size)`; `stride` may exceed
+     * `stripe_size` to skip alignment padding, as in
+     * `ErasureCode::ShardArena`. The buffer must end right after the last
+     * stripe. Leaves are computed on access, so the only allocation is the
+     * node array.
+     *
+     * @throws std::invalid_argument if the buffer does not split that way
+     */
+    [[nodiscard]]
+    static BasicTree build(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner);
 
+    /**
+     * @brief Same, with the leaf hashes already computed by the caller.
+     *
+     * `leaf_hashes[i]` must be SHA-256(0x00 || leaf i), e.g. accumulated
+     * while the stripes were being written; only the internal nodes are
+     * hashed here. Nothing checks the hashes against the leaves.
+     *
+     * @throws std::invalid_argument if the buffer does not split that way or
+     *         there is not one hash per stripe
+     */
     [[nodiscard]]
-    static Tree build(std::vector<std::vector<Byte>>&& leaves);
+    static BasicTree build(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner,
+        std::span<const Hash> leaf_hashes);
+
+    /// Same, for stripes packed back to back.
+    [[nodiscard]]
+    static BasicTree build(BytesSpan buffer, size_type stripe_size, std::shared_ptr<const void> owner)
+    {
+        return build(buffer, stripe_size, stripe_size, std::move(owner));
+    }
+
+    /**
+     * @brief Root of the tree whose leaf hashes are `leaf_hashes`.
+     *
+     * Only the internal nodes are hashed and nothing is kept, for checking a
+     * commitment to leaves hashed elsewhere. An empty span gives the root of
+     * an empty tree.
+     */
+    [[nodiscard]]
+    static Hash root_of(std::span<const Hash> leaf_hashes);
 
     [[nodiscard]] const Hash& root() const noexcept { return root_hash_; }
-    [[nodiscard]] std::expected<Proof, std::error_code> prove(size_type leaf_index) const;
+
+    /**
+     * @brief Proves one leaf.
+     *
+     * Fails with `invalid_argument` if the index is out of range, and with
+     * `value_too_large` if the path has more than MAX_PROOF_SIBLINGS<Arity>
+     * siblings, which never happens up to MAX_PROOF_LEAVES leaves; the
+     * multi-leaf overload has no such limit.
+     */
+    [[nodiscard]] std::expected<BasicProof<Arity>, std::error_code> prove(size_type leaf_index) const;
+
+    /**
+     * @brief Proves several leaves at once.
+     *
+     * Indices may come in any order and repeat; the proof lists each once,
+     * ascending. Fails with `invalid_argument` if the set is empty or an
+     * index is out of range.
+     */
+    [[nodiscard]] std::expected<MultiProof, std::error_code> prove(std::span<const size_type> leaf_indices) const;
+
     [[nodiscard]] const_reference leaf(size_type leaf_index) const;
 
-    [[nodiscard]] const_iterator begin() const noexcept { return leaves_.begin(); }
-    [[nodiscard]] const_iterator cbegin() const noexcept { return leaves_.cbegin(); }
-    [[nodiscard]] const_iterator end() const noexcept { return leaves_.end(); }
-    [[nodiscard]] const_iterator cend() const noexcept { return leaves_.end(); }
+    [[nodiscard]] const_iterator begin() const noexcept;
+    [[nodiscard]] const_iterator cbegin() const noexcept;
+    [[nodiscard]] const_iterator end() const noexcept;
+    [[nodiscard]] const_iterator cend() const noexcept;
 
-    [[nodiscard]] size_type size() const noexcept { return leaves_.size(); }
-    [[nodiscard]] bool empty() const noexcept { return leaves_.empty(); }
+    [[nodiscard]] size_type size() const noexcept { return count_; }
+    [[nodiscard]] bool empty() const noexcept { return count_ == 0; }
 
 private:
     Hash root_hash_ {};
+    // Levels stored back to back from the padded leaves up to the root, so
+    // the children of one node are adjacent.
     std::vector<Hash> nodes_;
-    std::vector<std::vector<Byte>> leaves_;
+    size_type padded_count_ = 0;
+    size_type depth_ = 0;
+    // Leaves are either arbitrary views (`views_`), or `count_` stripes of
+    // `stripe_size_` bytes laid out `stride_` apart from `base_`.
+    std::vector<BytesSpan> views_;
+    const Byte* base_ = nullptr;
+    size_type stripe_size_ = 0;
+    size_type stride_ = 0;
+    size_type count_ = 0;
+    std::shared_ptr<const void> owner_;
+
+    [[nodiscard]] BytesSpan leaf_unchecked(size_type leaf_index) const noexcept
+    {
+        return views_.empty() ? BytesSpan(base_ + (leaf_index * stride_), stripe_size_) : views_[leaf_index];
+    }
+
+    // Node `index` of `level`, where level 0 holds the padded leaves
+    [[nodiscard]] const Hash& node(size_type level, size_type index) const noexcept
+    {
+        return nodes_[level_offset(level) + index];
+    }
+
+    [[nodiscard]] size_type level_offset(size_type level) const noexcept;
+
+    // Checks the stripe geometry and records it, without hashing anything
+    [[nodiscard]] static BasicTree striped(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner);
+
+    // Fills `nodes_`; the leaf level comes from `leaf_hashes` unless empty
+    void hash_nodes(std::span<const Hash> leaf_hashes);
 };
 
+/// Random-access iterator yielding each leaf as a span.
+template <std::size_t Arity>
+class BasicTree<Arity>::const_iterator {
+public:
+    using iterator_concept = std::random_access_iterator_tag;
+    using value_type = BytesSpan;
+    using difference_type = std::ptrdiff_t;
+    using reference = BytesSpan;
+
+    const_iterator() = default;
+
+    reference operator*() const noexcept { return tree_->leaf_unchecked(index_); }
+    reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+    const_iterator& operator++() noexcept
+    {
+        ++index_;
+        return *this;
+    }
+    const_iterator operator++(int) noexcept
+    {
+        auto tmp = *this;
+        ++index_;
+        return tmp;
+    }
+    const_iterator& operator--() noexcept
+    {
+        --index_;
+        return *this;
+    }
+    const_iterator operator--(int) noexcept
+    {
+        auto tmp = *this;
+        --index_;
+        return tmp;
+    }
+    const_iterator& operator+=(difference_type n) noexcept
+    {
+        index_ += n;
+        return *this;
+    }
+    const_iterator& operator-=(difference_type n) noexcept
+    {
+        index_ -= n;
+        return *this;
+    }
+
+    friend const_iterator operator+(const_iterator it, difference_type n) noexcept { return it += n; }
+    friend const_iterator operator+(difference_type n, const_iterator it) noexcept { return it += n; }
+    friend const_iterator operator-(const_iterator it, difference_type n) noexcept { return it -= n; }
+    friend difference_type operator-(const const_iterator& a, const const_iterator& b) noexcept
+    {
+        return static_cast<difference_type>(a.index_) - static_cast<difference_type>(b.index_);
+    }
+    friend bool operator==(const const_iterator& a, const const_iterator& b) noexcept { return a.index_ == b.index_; }
+    friend auto operator<=>(const const_iterator& a, const const_iterator& b) noexcept { return a.index_ <=> b.index_; }
+
+private:
+    friend class BasicTree;
+
+    const_iterator(const BasicTree* tree, size_type index) noexcept
+        : tree_(tree)
+        , index_(index)
+    {
+    }
+
+    const BasicTree* tree_ = nullptr;
+    size_type index_ = 0;
+};
+
+template <std::size_t Arity>
+typename BasicTree<Arity>::const_iterator BasicTree<Arity>::begin() const noexcept { return { this, 0 }; }
+template <std::size_t Arity>
+typename BasicTree<Arity>::const_iterator BasicTree<Arity>::cbegin() const noexcept { return begin(); }
+template <std::size_t Arity>
+typename BasicTree<Arity>::const_iterator BasicTree<Arity>::end() const noexcept { return { this, count_ }; }
+template <std::size_t Arity>
+typename BasicTree<Arity>::const_iterator BasicTree<Arity>::cend() const noexcept { return end(); }
+
+using Tree = BasicTree<2>;
+
+extern template class BasicTree<2>;
+extern template class BasicTree<4>;
+extern template class BasicTree<8>;
+extern template class BasicTree<16>;
+
+/// Checks a proof from `BasicTree<Arity>`; call as `verify<4>(...)`.
+template <std::size_t Arity>
+[[nodiscard]] bool verify(BytesSpan leaf, const BasicProof<Arity>& proof, const Hash& root) noexcept;
+
 [[nodiscard]]
 bool verify(BytesSpan leaf, const Proof& proof, const Hash& root) noexcept;
 
+/**
+ * @brief Checks that `leaves[i]` is leaf `proof.leaf_indices[i]` under `root`.
+ *
+ * Hashes each proven leaf and each internal node above them exactly once,
+ * several lanes at a time per level. Fails on malformed proofs, including
+ * unused siblings.
+ */
+template <std::size_t Arity>
+[[nodiscard]] bool verify(std::span<const BytesSpan> leaves, const MultiProof& proof, const Hash& root);
+
+[[nodiscard]]
+bool verify(std::span<const BytesSpan> leaves, const MultiProof& proof, const Hash& root);
+
+/**
+ * @brief Verifies many proofs against one root, reusing authenticated nodes.
+ *
+ * Once a proof checks out, every node on its path and every sibling it
+ * carried are known to belong to the tree under `root`. They are remembered
+ * by position, and later walks stop at the first node that matches a
+ * remembered one, so N proofs for one root no longer rehash the upper
+ * levels N times. Nothing is remembered from a proof that fails.
+ *
+ * A leaf is accepted iff it is leaf `leaf_index` of the tree under `root`.
+ * Once a remembered node settles that, the remaining siblings are not read,
+ * so a proof with corrupted upper siblings can pass where `verify` would
+ * reject it; the leaf itself is still authenticated. Proofs whose
+ * `leaf_index` does not fit in their depth are rejected. Thread-safe.
+ */
+template <std::size_t Arity>
+class BasicBatchVerifier {
+public:
+    explicit BasicBatchVerifier(const Hash& root);
+
+    [[nodiscard]] const Hash& root() const noexcept { return root_; }
+
+    [[nodiscard]] bool verify(BytesSpan leaf, const BasicProof<Arity>& proof);
+
+    /**
+     * @brief Verifies `proofs[i]` for `leaves[i]` into `results[i]`.
+     *
+     * The leaves are hashed together, several lanes at a time, before the
+     * paths are walked.
+     *
+     * @throws std::invalid_argument if the three spans differ in size
+     */
+    void verify(std::span<const BytesSpan> leaves, std::span<const BasicProof<Arity>> proofs, std::span<bool> results);
+
+    /// Number of authenticated nodes currently remembered.
+    [[nodiscard]] std::size_t cached_nodes() const;
+
+private:
+    Hash root_;
+    mutable std::mutex mutex_;
+    // Node j of the level d below the root sits at Arity^d + j; levels
+    // never overlap and the root is 1.
+    std::unordered_map<std::size_t, Hash> known_;
+
+    [[nodiscard]] bool walk(const Hash& leaf_hash, const BasicProof<Arity>& proof);
+};
+
+using BatchVerifier = BasicBatchVerifier<2>;
+
+extern template class BasicBatchVerifier<2>;
+extern template class BasicBatchVerifier<4>;
+extern template class BasicBatchVerifier<8>;
+extern template class BasicBatchVerifier<16>;
+
 static_assert(std::ranges::random_access_range<Tree>);
 static_assert(std::ranges::sized_range<Tree>);
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <expected>
+#include <span>
+#include <system_error>
+#include <vector>
+
+#include "crypto/common.hpp"
+#include "crypto/erasure_code.hpp"
+#include "crypto/merkle_tree.hpp"
+
+namespace Honey::Crypto {
+
+/// Erasure-coded payload together with the Merkle commitment to its shards.
+struct CommittedShards {
+    ErasureCode::ShardArena shards;
+    /// Leaf i is shard i, borrowed from `shards`.
+    MerkleTree::Tree tree;
+    /// `proofs[i]` proves shard i against `tree.root()`.
+    std::vector<MerkleTree::Proof> proofs;
+};
+
+/**
+ * @brief Encodes `payload` and commits to its N shards in one pass.
+ *
+ * Every shard is hashed stripe by stripe as the encoder finishes writing it,
+ * so building the tree takes no second pass over the shards; only the
+ * internal nodes are hashed afterwards. This is a restructuring of the two
+ * steps, not a different computation: the shards, root and proofs are
+ * identical to
+ * `encode_to_arena` followed by `Tree::build` over its views and a `prove`
+ * per shard. This is what a leader's `async_build_merkle_tree(K, N, data)`
+ * should run.
+ */
+[[nodiscard]]
+auto encode_and_commit(const ErasureCode::Context& ctx, BytesSpan payload)
+    -> std::expected<CommittedShards, std::error_code>;
+
+/**
+ * @brief Decodes `shards` and checks that the payload's shards commit to `root`.
+ *
+ * An RBC receiver must re-encode what it decoded and compare Merkle roots,
+ * or a leader that dispersed inconsistent shards could make honest nodes
+ * deliver different payloads. Rather than a decode followed by
+ * `encode_and_commit`, this fuses the two: `reencode_streaming` recovers the
+ * missing data blocks and regenerates only the shards decoding did not
+ * start from, and every shard is hashed stripe by stripe by the multi-lane
+ * hasher while the stripe is in cache. Received shards are hashed in place,
+ * never copied. Returns the payload length like `ErasureCode::decode`.
+ *
+ * Fails with `bad_message` if the shards do not commit to `root`, in which
+ * case `output` holds garbage.
+ */
+[[nodiscard]]
+auto decode_and_recommit(const ErasureCode::Context& ctx, std::span<const ErasureCode::ShardView> shards,
+    const MerkleTree::Hash& root, MutableBytesSpan output)
+    -> std::expected<std::size_t, std::error_code>;
+
+} // namespace Honey::Crypto
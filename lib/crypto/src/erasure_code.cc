@@ -1,7 +1,15 @@
 #include "crypto/erasure_code.hpp"
+#include "gf16_fft.hpp"
+#include <algorithm>
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <cstring>
 #include <isa-l/erasure_code.h>
+#include <list>
+#include <mutex>
+#include <new>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -29,199 +37,633 @@ namespace {
 
     // --- Encoding Helpers ---
 
+    size_t align_up(size_t n, size_t alignment)
+    {
+        return (n + alignment - 1) / alignment * alignment;
+    }
+
+    std::shared_ptr<Byte[]> allocate_aligned(size_t bytes)
+    {
+        auto* ptr = static_cast<Byte*>(::operator new[](bytes, std::align_val_t { SHARD_ALIGNMENT }));
+        return { ptr, [](Byte* p) { ::operator delete[](p, std::align_val_t { SHARD_ALIGNMENT }); } };
+    }
+
+    // --- Striping ---
+
+    // 每个列条带涉及的全部输入输出字节数上限（约为 L2 大小）
+    constexpr size_t STRIPE_BUDGET = 1 << 20;
+
+    size_t stripe_width(size_t rows)
+    {
+        return align_up(std::max<size_t>(STRIPE_BUDGET / rows, SHARD_ALIGNMENT), SHARD_ALIGNMENT);
+    }
+
     /**
-     * @brief 将数据填充成K的倍数，并添加长度前缀
-     * @return (缓冲区, 每块大小)
+     * @brief 将 [0, len) 按 width 切分为列条带，交由调用方的执行器并行处理
+     *
+     * 没有执行器时在当前线程依次处理各条带。
      */
-    std::pair<std::vector<Byte>, size_t> prepare_encode_buffer(BytesSpan data, int K)
+    template <typename Kernel>
+    void for_each_stripe(const ParallelFor& parallel, size_t len, size_t width, Kernel&& kernel)
     {
-        size_t raw_len = data.size();
-        size_t payload_len = LEN_PREFIX_SIZE + raw_len;
-        size_t total_len = payload_len;
-        if (total_len % K != 0) {
-            total_len += K - (total_len % K);
+        size_t stripes = (len + width - 1) / width;
+        if (stripes <= 1) {
+            kernel(0, len);
+            return;
         }
-        size_t block_size = total_len / K;
-
-        std::vector<Byte> buffer(total_len, Byte { 0 });
-        write_u32_le(buffer.data(), static_cast<uint32_t>(raw_len));
-        std::memcpy(buffer.data() + LEN_PREFIX_SIZE, data.data(), raw_len);
 
-        return { std::move(buffer), block_size };
+        auto run = [&](size_t stripe) {
+            size_t offset = stripe * width;
+            kernel(offset, std::min(width, len - offset));
+        };
+        if (!parallel) {
+            for (size_t stripe = 0; stripe < stripes; ++stripe) {
+                run(stripe);
+            }
+            return;
+        }
+        parallel(stripes, run);
     }
 
     /**
-     * @brief 准备编码的输入输出指针
+     * @brief 对 [offset, offset+n) 这一列条带执行 ec_encode_data（n == len 时直接整块调用）
      */
-    void prepare_encode_pointers(
-        std::span<Byte> buffer,
-        size_t block_size,
-        int K,
-        std::vector<std::vector<Byte>>& result,
-        std::vector<unsigned char*>& data_ptrs,
-        std::vector<unsigned char*>& parity_ptrs)
+    void encode_data_stripe(
+        size_t offset,
+        size_t n,
+        size_t len,
+        int k,
+        int rows,
+        unsigned char* tables,
+        unsigned char* const* src,
+        unsigned char* const* dest)
     {
-        // 填充前 K 个 (Systematic)
-        for (int i = 0; i < K; ++i) {
-            result[i].resize(block_size);
-            std::memcpy(result[i].data(), &buffer[i * block_size], block_size);
-            data_ptrs[i] = u8ptr(result[i].data());
+        if (n == len) {
+            ec_encode_data(static_cast<int>(len), k, rows, tables,
+                const_cast<unsigned char**>(src), const_cast<unsigned char**>(dest));
+            return;
         }
 
-        // 预分配后 N-K 个 (Parity)
-        int N = result.size();
-        for (int i = 0; i < N - K; ++i) {
-            result[K + i].resize(block_size);
-            parity_ptrs[i] = u8ptr(result[K + i].data());
+        std::vector<unsigned char*> ptrs(k + rows);
+        for (int i = 0; i < k; ++i) {
+            ptrs[i] = src[i] + offset;
+        }
+        for (int i = 0; i < rows; ++i) {
+            ptrs[k + i] = dest[i] + offset;
         }
+        ec_encode_data(static_cast<int>(n), k, rows, tables, ptrs.data(), ptrs.data() + k);
+    }
+
+    /**
+     * @brief 按列条带执行 ec_encode_data；没有执行器时整块调用一次
+     *
+     * 各列互不相关，因此条带化的结果与整块调用逐字节一致。
+     */
+    void striped_encode_data(
+        const ParallelFor& parallel,
+        size_t len,
+        int k,
+        int rows,
+        const unsigned char* g_tbls,
+        unsigned char* const* src,
+        unsigned char* const* dest)
+    {
+        auto* tables = const_cast<unsigned char*>(g_tbls);
+        size_t width = parallel ? stripe_width(k + rows) : std::max<size_t>(len, 1);
+
+        for_each_stripe(parallel, len, width, [&](size_t offset, size_t n) {
+            encode_data_stripe(offset, n, len, k, rows, tables, src, dest);
+        });
     }
 
+    // --- Decoding Helpers ---
+
     /**
-     * @brief 初始化编码表并执行编码
+     * @brief 按逻辑偏移从各数据块中拷贝（块可能比长度前缀还短）
      */
-    void perform_encode(
+    void copy_from_blocks(
+        std::span<const unsigned char* const> blocks,
         size_t block_size,
-        int K,
-        int N,
-        std::span<unsigned char*> data_ptrs,
-        std::span<unsigned char*> parity_ptrs)
+        size_t offset,
+        Byte* out,
+        size_t len)
     {
-        // 生成柯西矩阵
-        std::vector<unsigned char> encode_matrix(N * K);
-        gf_gen_cauchy1_matrix(encode_matrix.data(), N, K);
+        while (len > 0) {
+            size_t block = offset / block_size;
+            size_t in_block = offset % block_size;
+            size_t n = std::min(len, block_size - in_block);
+            std::memcpy(out, blocks[block] + in_block, n);
+            out += n;
+            offset += n;
+            len -= n;
+        }
+    }
 
-        // 获取校验部分的子矩阵
-        unsigned char* parity_matrix = &encode_matrix[K * K];
+    /**
+     * @brief 读取长度前缀，并将原始数据从数据块直接拷贝到输出
+     * @return 原始数据长度
+     */
+    std::expected<size_t, std::error_code> extract_original_data(
+        std::span<const unsigned char* const> blocks,
+        size_t block_size,
+        MutableBytesSpan output)
+    {
+        const size_t total_len = blocks.size() * block_size;
+        if (total_len < LEN_PREFIX_SIZE)
+            return std::unexpected(std::make_error_code(std::errc::bad_message));
 
-        // 初始化 SIMD 查找表
-        std::vector<unsigned char> g_tbls((N - K) * K * 32);
-        ec_init_tables(K, N - K, parity_matrix, g_tbls.data());
+        // 提取长度
+        std::array<Byte, LEN_PREFIX_SIZE> prefix {};
+        copy_from_blocks(blocks, block_size, 0, prefix.data(), LEN_PREFIX_SIZE);
+        uint32_t original_len = read_u32_le(prefix.data());
+        if (original_len > total_len - LEN_PREFIX_SIZE)
+            return std::unexpected(std::make_error_code(std::errc::bad_message));
+        if (original_len > output.size())
+            return std::unexpected(std::make_error_code(std::errc::no_buffer_space));
 
-        // 执行编码
-        ec_encode_data(block_size, K, N - K, g_tbls.data(), data_ptrs.data(), parity_ptrs.data());
+        // 提取原始数据
+        copy_from_blocks(blocks, block_size, LEN_PREFIX_SIZE, output.data(), original_len);
+        return original_len;
     }
 
-    // --- Decoding Helpers ---
+    /**
+     * @brief 收到的分片按索引排列（缺失为 nullptr），重复的索引只取第一个
+     */
+    struct ReceivedShards {
+        size_t block_size;
+        std::vector<const unsigned char*> by_index;
+    };
 
     /**
-     * @brief 收集接收到的块并检查是否为恒等式（已是原始数据）
-     * @return (是否为恒等式, 块索引)
+     * @brief 校验索引范围、块大小一致且至少有 K 个不同分片
      */
-    std::pair<bool, std::vector<int>> collect_decode_shards(
-        const std::map<int, std::vector<Byte>>& received_shards,
-        int K,
-        size_t block_size,
-        std::vector<unsigned char*>& decode_ptrs)
+    std::expected<ReceivedShards, std::error_code> index_shards(const Context& ctx, std::span<const ShardView> shards)
+    {
+        if (shards.empty()) {
+            return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+        }
+
+        ReceivedShards received { .block_size = shards.front().data.size(), .by_index = std::vector<const unsigned char*>(ctx.N(), nullptr) };
+        int distinct = 0;
+        for (const auto& [idx, data] : shards) {
+            if (idx < 0 || idx >= ctx.N() || data.size() != received.block_size) {
+                return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+            }
+            if (received.by_index[idx] == nullptr) {
+                received.by_index[idx] = u8ptr(data);
+                distinct++;
+            }
+        }
+
+        if (distinct < ctx.K() || (ctx.backend() == Backend::Gf16Fft && received.block_size % 2 != 0)) {
+            return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+        }
+        return received;
+    }
+
+    /**
+     * @brief GF(2^8) 解码所用的分片：依次为已到达的数据分片和最前面的若干校验分片，共 K 个
+     */
+    std::vector<int> gf8_decode_indexes(const ReceivedShards& received, int K)
     {
-        bool is_identity = true;
         std::vector<int> decode_indexes;
+        for (int i = 0; i < static_cast<int>(received.by_index.size()) && static_cast<int>(decode_indexes.size()) < K; ++i) {
+            if (received.by_index[i] != nullptr)
+                decode_indexes.push_back(i);
+        }
+        return decode_indexes;
+    }
 
-        int count = 0;
-        for (const auto& [idx, data] : received_shards) {
-            if (count >= K)
-                break;
+} // namespace
 
-            if (data.size() != block_size) {
-                is_identity = false;
-                continue;
-            }
+// --- Decode Table Cache ---
+
+/**
+ * @brief 解码表的 LRU 缓存，键为参与恢复的分片索引集合
+ *
+ * 诚实节点收到的 ECHO 集合在各实例之间高度重复，命中时可以跳过矩阵求逆与
+ * ec_init_tables。表以 shared_ptr 交出，淘汰时不会影响正在使用它的解码。
+ */
+class DecodeTableCache {
+public:
+    using Key = std::bitset<256>;
+    using Tables = std::shared_ptr<const std::vector<unsigned char>>;
+
+    explicit DecodeTableCache(size_t capacity)
+        : capacity_(capacity)
+    {
+    }
 
-            decode_ptrs[count] = const_cast<unsigned char*>(u8ptr(data.data()));
-            decode_indexes.push_back(idx);
+    Tables find(const Key& key)
+    {
+        std::lock_guard lock(mutex_);
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return nullptr;
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->second;
+    }
 
-            if (idx != count)
-                is_identity = false;
+    void insert(const Key& key, Tables tables)
+    {
+        if (capacity_ == 0)
+            return;
 
-            count++;
+        std::lock_guard lock(mutex_);
+        if (auto it = index_.find(key); it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return;
         }
+        entries_.emplace_front(key, std::move(tables));
+        index_.emplace(key, entries_.begin());
+        if (entries_.size() > capacity_) {
+            index_.erase(entries_.back().first);
+            entries_.pop_back();
+        }
+    }
+
+    size_t size() const
+    {
+        std::lock_guard lock(mutex_);
+        return entries_.size();
+    }
+
+private:
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    std::list<std::pair<Key, Tables>> entries_;
+    std::unordered_map<Key, std::list<std::pair<Key, Tables>>::iterator> index_;
+};
+
+// --- Codec Engine ---
+
+class ErasureCodeImpl {
+public:
+    /**
+     * @brief 为 count 个分片分配对齐的连续内存
+     */
+    static ShardArena allocate_arena(int count, size_t block_size)
+    {
+        ShardArena arena;
+        arena.block_size_ = block_size;
+        arena.stride_ = align_up(std::max<size_t>(block_size, 1), SHARD_ALIGNMENT);
+        arena.count_ = count;
+        arena.storage_ = allocate_aligned(arena.stride_ * count);
+        arena.base_ = arena.storage_.get();
+        return arena;
+    }
+
+    /**
+     * @brief 长度前缀 + 数据填充为 K 的倍数（GF(2^16) 的块再补齐为偶数）
+     */
+    static size_t block_size_for(const Context& ctx, size_t data_size)
+    {
+        size_t block_size = (LEN_PREFIX_SIZE + data_size + ctx.K_ - 1) / ctx.K_;
+        if (ctx.backend() == Backend::Gf16Fft) {
+            block_size = align_up(block_size, 2);
+        }
+        return block_size;
+    }
+
+    /**
+     * @brief 与 arena 共享内存、每个分片从 offset 处开始的视图
+     */
+    static ShardArena slice(const ShardArena& arena, size_t offset, size_t block_size)
+    {
+        ShardArena view = arena;
+        view.base_ += offset;
+        view.block_size_ = block_size;
+        return view;
+    }
+
+    static unsigned char* shard_ptr(const ShardArena& arena, int index)
+    {
+        return u8ptr(arena.base_ + (static_cast<size_t>(index) * arena.stride_));
+    }
 
-        return { is_identity, decode_indexes };
+    /**
+     * @brief 将长度前缀与数据直接写入各数据分片，并将填充部分清零
+     */
+    static void fill_data_shards(const ShardArena& arena, int K, BytesSpan data)
+    {
+        fill_data_columns(arena, K, data, 0, arena.block_size_);
     }
 
     /**
-     * @brief 对接收到的块进行矩阵求逆并恢复原始数据
-     * @return 错误码 或 空
+     * @brief 只写入各数据分片的 [offset, offset+len) 列
+     *
+     * 逻辑输入为 prefix || data，分片 i 的第 c 列对应其中第 i * block_size + c 个字节。
      */
-    std::expected<void, std::error_code> perform_matrix_inversion_decode(
-        const std::vector<int>& decode_indexes,
-        const std::vector<unsigned char*>& decode_ptrs,
+    static void fill_data_columns(const ShardArena& arena, int K, BytesSpan data, size_t offset, size_t len)
+    {
+        std::array<Byte, LEN_PREFIX_SIZE> prefix {};
+        write_u32_le(prefix.data(), static_cast<uint32_t>(data.size()));
+
+        const size_t total_len = LEN_PREFIX_SIZE + data.size();
+        for (int i = 0; i < K; ++i) {
+            Byte* dst = arena.base_ + (static_cast<size_t>(i) * arena.stride_) + offset;
+            size_t pos = (static_cast<size_t>(i) * arena.block_size_) + offset;
+            size_t written = 0;
+
+            while (written < len && pos < total_len) {
+                BytesSpan src = pos < LEN_PREFIX_SIZE
+                    ? BytesSpan(prefix).subspan(pos)
+                    : data.subspan(pos - LEN_PREFIX_SIZE);
+                size_t n = std::min(len - written, src.size());
+                std::memcpy(dst + written, src.data(), n);
+                written += n;
+                pos += n;
+            }
+            std::memset(dst + written, 0, len - written);
+        }
+    }
+
+    /**
+     * @brief 使用 Context 中预先生成的校验表执行编码
+     */
+    static void encode_parity(
+        const Context& ctx,
         size_t block_size,
-        int K,
-        int N,
-        std::vector<unsigned char*>& final_ptrs,
-        std::vector<std::vector<Byte>>& recovered_buffers)
+        std::span<unsigned char*> data_ptrs,
+        std::span<unsigned char*> parity_ptrs,
+        const ParallelFor& parallel)
+    {
+        // FFT 的工作区随 n 增长，即使串行也按条带处理以留在缓存内
+        if (ctx.fft_codec_) {
+            for_each_stripe(parallel, block_size, stripe_width(ctx.fft_codec_->rows()), [&](size_t offset, size_t len) {
+                ctx.fft_codec_->encode(offset, len, data_ptrs, parity_ptrs);
+            });
+            return;
+        }
+
+        striped_encode_data(parallel, block_size, ctx.K_, ctx.N_ - ctx.K_,
+            ctx.parity_g_tbls_.data(), data_ptrs.data(), parity_ptrs.data());
+    }
+
+    /**
+     * @brief 由 arena 的前 K 个分片计算其余校验分片
+     */
+    static void encode_arena(const Context& ctx, const ShardArena& arena, const ParallelFor& parallel)
     {
-        // 为恢复的数据分配空间
-        recovered_buffers.resize(K);
+        const int K = ctx.K_;
+        const int N = ctx.N_;
+
+        // 准备输入输出指针
+        std::vector<unsigned char*> data_ptrs(K);
+        std::vector<unsigned char*> parity_ptrs(N - K);
         for (int i = 0; i < K; ++i) {
-            recovered_buffers[i].resize(block_size);
-            final_ptrs[i] = u8ptr(recovered_buffers[i].data());
+            data_ptrs[i] = shard_ptr(arena, i);
+        }
+        for (int i = 0; i < N - K; ++i) {
+            parity_ptrs[i] = shard_ptr(arena, K + i);
+        }
+
+        encode_parity(ctx, arena.block_size_, data_ptrs, parity_ptrs, parallel);
+    }
+
+    /**
+     * @brief 逐条带填充数据、编码并交给 sink，条带在各步之间一直留在缓存中
+     */
+    static void encode_arena_streaming(const Context& ctx, const ShardArena& arena, BytesSpan data, const StripeSink& sink)
+    {
+        const int K = ctx.K_;
+        const int N = ctx.N_;
+
+        std::vector<unsigned char*> data_ptrs(K);
+        std::vector<unsigned char*> parity_ptrs(N - K);
+        for (int i = 0; i < K; ++i) {
+            data_ptrs[i] = shard_ptr(arena, i);
+        }
+        for (int i = 0; i < N - K; ++i) {
+            parity_ptrs[i] = shard_ptr(arena, K + i);
+        }
+
+        const size_t block_size = arena.block_size_;
+        const size_t rows = ctx.fft_codec_ ? ctx.fft_codec_->rows() : static_cast<size_t>(N);
+        auto* tables = const_cast<unsigned char*>(ctx.parity_g_tbls_.data());
+
+        for_each_stripe({}, block_size, stripe_width(rows), [&](size_t offset, size_t len) {
+            fill_data_columns(arena, K, data, offset, len);
+            if (ctx.fft_codec_) {
+                ctx.fft_codec_->encode(offset, len, data_ptrs, parity_ptrs);
+            } else {
+                encode_data_stripe(offset, len, block_size, K, N - K, tables, data_ptrs.data(), parity_ptrs.data());
+            }
+            sink(arena, offset, len);
+        });
+    }
+
+    /**
+     * @brief 通过 GF(2^16) 加性 FFT 恢复缺失的数据块
+     */
+    static void recover_fft(
+        const Context& ctx,
+        size_t block_size,
+        std::span<const unsigned char* const> shards,
+        std::span<const int> missing,
+        std::span<unsigned char* const> recovered,
+        const ParallelFor& parallel)
+    {
+        auto locator = ctx.fft_codec_->error_locator(shards);
+        for_each_stripe(parallel, block_size, stripe_width(ctx.fft_codec_->rows()), [&](size_t offset, size_t len) {
+            ctx.fft_codec_->decode(offset, len, locator, shards, missing, recovered);
+        });
+    }
+
+    /**
+     * @brief 获取（或生成并缓存）仅恢复缺失数据块的解码表
+     *
+     * decode_indexes 依次为 K-e 个已到达的数据分片和 e 个校验分片，missing 为
+     * e 个缺失的数据分片。记 S 为校验行在缺失列上的 e×e 子矩阵、A 为校验行在
+     * 已到达数据列上的子矩阵，则 d_missing = S⁻¹·A·d_present ⊕ S⁻¹·parity，
+     * 因此解码矩阵为 e×K 的 [S⁻¹·A | S⁻¹]，而非完整的 K×K 逆矩阵。
+     */
+    static auto decode_tables(
+        const Context& ctx,
+        std::span<const int> decode_indexes,
+        std::span<const int> missing)
+        -> std::expected<DecodeTableCache::Tables, std::error_code>
+    {
+        const int K = ctx.K_;
+        const int e = static_cast<int>(missing.size());
+        const int present = K - e;
+
+        DecodeTableCache::Key key;
+        for (int idx : decode_indexes) {
+            key.set(static_cast<size_t>(idx));
+        }
+
+        if (auto tables = ctx.decode_cache_->find(key)) {
+            return tables;
         }
 
-        // 构造编码矩阵
-        std::vector<unsigned char> encode_matrix(N * K);
-        gf_gen_cauchy1_matrix(encode_matrix.data(), N, K);
+        auto coeff = [&](int row, int col) {
+            return ctx.encode_matrix_[(row * K) + col];
+        };
 
-        // 构造解码矩阵（从接收到的行）
-        std::vector<unsigned char> decode_matrix(K * K);
-        for (int i = 0; i < K; i++) {
-            int src_idx = decode_indexes[i];
-            std::memcpy(&decode_matrix[i * K], &encode_matrix[src_idx * K], K);
+        // 构造 S 并求逆（柯西矩阵的任意方子阵均可逆）
+        std::vector<unsigned char> sub_matrix(e * e);
+        for (int r = 0; r < e; ++r) {
+            for (int c = 0; c < e; ++c) {
+                sub_matrix[(r * e) + c] = coeff(decode_indexes[present + r], missing[c]);
+            }
         }
 
-        // 求逆矩阵
-        std::vector<unsigned char> invert_matrix(K * K);
-        if (gf_invert_matrix(decode_matrix.data(), invert_matrix.data(), K) < 0) {
+        std::vector<unsigned char> invert_matrix(e * e);
+        if (gf_invert_matrix(sub_matrix.data(), invert_matrix.data(), e) < 0) {
             return std::unexpected(std::make_error_code(std::errc::operation_not_permitted));
         }
 
-        // 初始化解码表
-        std::vector<unsigned char> g_tbls(K * K * 32);
-        ec_init_tables(K, K, invert_matrix.data(), g_tbls.data());
+        // 构造 e×K 解码矩阵 [S⁻¹·A | S⁻¹]
+        std::vector<unsigned char> decode_matrix(e * K);
+        for (int r = 0; r < e; ++r) {
+            const unsigned char* inv_row = &invert_matrix[r * e];
+            unsigned char* out_row = &decode_matrix[r * K];
+            for (int t = 0; t < present; ++t) {
+                unsigned char acc = 0;
+                for (int c = 0; c < e; ++c) {
+                    acc ^= gf_mul(inv_row[c], coeff(decode_indexes[present + c], decode_indexes[t]));
+                }
+                out_row[t] = acc;
+            }
+            std::memcpy(out_row + present, inv_row, e);
+        }
 
-        // 执行解码（通过逆矩阵乘法恢复原始数据）
-        ec_encode_data(block_size, K, K, g_tbls.data(),
-            const_cast<unsigned char**>(decode_ptrs.data()),
-            final_ptrs.data());
+        // 初始化解码表
+        auto g_tbls = std::make_shared<std::vector<unsigned char>>(e * K * 32);
+        ec_init_tables(K, e, decode_matrix.data(), g_tbls->data());
 
-        return {};
+        ctx.decode_cache_->insert(key, g_tbls);
+        return g_tbls;
     }
 
     /**
-     * @brief 从恢复的块中移除长度前缀和填充
+     * @brief 恢复缺失的数据块并重新生成其余分片，逐条带交给 sink
+     *
+     * 每个条带内先用解码表恢复缺失的数据列，再用 Context 的校验表只为需要
+     * 重新生成的校验行编码，整个过程约等于一次编码的工作量。
      */
-    std::expected<std::vector<Byte>, std::error_code> extract_original_data(
-        std::span<unsigned char*> final_ptrs,
-        int K,
-        size_t block_size)
+    static auto reencode(const Context& ctx, const ReceivedShards& received, MutableBytesSpan output,
+        const ShardsStripeSink& sink)
+        -> std::expected<size_t, std::error_code>
     {
-        // 拼接所有块
-        std::vector<Byte> buffer;
-        buffer.reserve(K * block_size);
+        const int K = ctx.K_;
+        const int N = ctx.N_;
+        const size_t block_size = received.block_size;
+        const auto& by_index = received.by_index;
+
+        // 收到的数据分片原样保留；GF(2^8) 下参与解码的校验分片也原样保留，
+        // 因为由解码结果重新编码得到的正是它们自己
+        std::vector<const unsigned char*> shard_ptrs(N, nullptr);
+        std::vector<int> missing;
         for (int i = 0; i < K; ++i) {
-            const Byte* ptr = reinterpret_cast<const Byte*>(final_ptrs[i]);
-            buffer.insert(buffer.end(), ptr, ptr + block_size);
+            shard_ptrs[i] = by_index[i];
+            if (by_index[i] == nullptr)
+                missing.push_back(i);
         }
 
-        // 提取长度
-        if (buffer.size() < LEN_PREFIX_SIZE)
-            return std::unexpected(std::make_error_code(std::errc::bad_message));
+        std::vector<int> decode_indexes;
+        std::vector<int> regenerate;
+        if (ctx.fft_codec_) {
+            for (int i = K; i < N; ++i) {
+                regenerate.push_back(i);
+            }
+        } else {
+            decode_indexes = gf8_decode_indexes(received, K);
+            for (int i = K, next = 0; i < N; ++i) {
+                while (next < K && decode_indexes[next] < i)
+                    ++next;
+                if (next < K && decode_indexes[next] == i) {
+                    shard_ptrs[i] = by_index[i];
+                } else {
+                    regenerate.push_back(i);
+                }
+            }
+        }
 
-        uint32_t original_len = read_u32_le(buffer.data());
-        if (original_len > buffer.size() - LEN_PREFIX_SIZE)
-            return std::unexpected(std::make_error_code(std::errc::bad_message));
+        const int e = static_cast<int>(missing.size());
+        const int m = static_cast<int>(regenerate.size());
+        ShardArena scratch = allocate_arena(e + m, block_size);
+        std::vector<unsigned char*> recovered_ptrs(e);
+        std::vector<unsigned char*> regenerated_ptrs(m);
+        for (int i = 0; i < e; ++i) {
+            recovered_ptrs[i] = shard_ptr(scratch, i);
+            shard_ptrs[missing[i]] = recovered_ptrs[i];
+        }
+        for (int i = 0; i < m; ++i) {
+            regenerated_ptrs[i] = shard_ptr(scratch, e + i);
+            shard_ptrs[regenerate[i]] = regenerated_ptrs[i];
+        }
 
-        // 提取原始数据
-        std::vector<Byte> output(original_len);
-        std::memcpy(output.data(), buffer.data() + LEN_PREFIX_SIZE, original_len);
+        std::vector<unsigned char*> data_ptrs(K);
+        for (int i = 0; i < K; ++i) {
+            data_ptrs[i] = const_cast<unsigned char*>(shard_ptrs[i]);
+        }
+        std::vector<BytesSpan> views(N);
+        for (int i = 0; i < N; ++i) {
+            views[i] = { reinterpret_cast<const Byte*>(shard_ptrs[i]), block_size };
+        }
+
+        // 解码表与校验表都在进入条带循环前准备好
+        DecodeTableCache::Tables decode_g_tbls;
+        std::vector<unsigned char*> decode_ptrs;
+        std::vector<std::uint16_t> locator;
+        std::vector<unsigned char> parity_g_tbls;
+        if (ctx.fft_codec_) {
+            if (e > 0)
+                locator = ctx.fft_codec_->error_locator(by_index);
+        } else {
+            if (e > 0) {
+                auto g_tbls = decode_tables(ctx, decode_indexes, missing);
+                if (!g_tbls) {
+                    return std::unexpected(g_tbls.error());
+                }
+                decode_g_tbls = std::move(*g_tbls);
+                for (int idx : decode_indexes) {
+                    decode_ptrs.push_back(const_cast<unsigned char*>(by_index[idx]));
+                }
+            }
+            // 校验行 r 的表是 parity_g_tbls_ 中连续的 K*32 字节
+            const size_t row_tbls = static_cast<size_t>(K) * 32;
+            parity_g_tbls.resize(m * row_tbls);
+            for (int i = 0; i < m; ++i) {
+                std::memcpy(&parity_g_tbls[i * row_tbls], &ctx.parity_g_tbls_[(regenerate[i] - K) * row_tbls], row_tbls);
+            }
+        }
+
+        if (block_size > 0) {
+            const size_t rows = ctx.fft_codec_ ? ctx.fft_codec_->rows() : static_cast<size_t>(N);
+            for_each_stripe({}, block_size, stripe_width(rows), [&](size_t offset, size_t len) {
+                if (ctx.fft_codec_) {
+                    if (e > 0)
+                        ctx.fft_codec_->decode(offset, len, locator, by_index, missing, recovered_ptrs);
+                    ctx.fft_codec_->encode(offset, len, data_ptrs, regenerated_ptrs);
+                } else {
+                    if (e > 0)
+                        encode_data_stripe(offset, len, block_size, K, e, const_cast<unsigned char*>(decode_g_tbls->data()), decode_ptrs.data(), recovered_ptrs.data());
+                    if (m > 0)
+                        encode_data_stripe(offset, len, block_size, K, m, parity_g_tbls.data(), data_ptrs.data(), regenerated_ptrs.data());
+                }
+                sink(views, offset, len);
+            });
+        }
 
-        return output;
+        return extract_original_data(std::span(shard_ptrs).first(K), block_size, output);
     }
+};
 
-} // namespace
+std::vector<BytesSpan> ShardArena::views() const
+{
+    std::vector<BytesSpan> result;
+    result.reserve(count_);
+    for (int i = 0; i < count_; ++i) {
+        result.push_back((*this)[i]);
+    }
+    return result;
+}
 
-auto encode(const Context& ctx, BytesSpan data)
-    -> std::expected<std::vector<std::vector<Byte>>, std::error_code>
+auto encode_to_arena(const Context& ctx, BytesSpan data, const ParallelFor& parallel)
+    -> std::expected<ShardArena, std::error_code>
 {
     int K = ctx.K();
     int N = ctx.N();
@@ -231,75 +673,237 @@ auto encode(const Context& ctx, BytesSpan data)
         return std::unexpected(std::make_error_code(std::errc::file_too_large));
     }
 
-    // 准备输入缓冲区
-    auto [buffer, block_size] = prepare_encode_buffer(data, K);
+    // 所有分片共用一块对齐内存，数据只拷贝一次
+    ShardArena arena = ErasureCodeImpl::allocate_arena(N, ErasureCodeImpl::block_size_for(ctx, data.size()));
+    ErasureCodeImpl::fill_data_shards(arena, K, data);
 
-    // 准备输入输出指针
-    std::vector<std::vector<Byte>> result(N);
-    std::vector<unsigned char*> data_ptrs(K);
-    std::vector<unsigned char*> parity_ptrs(N - K);
+    // 执行编码（复用 Context 中的校验表）
+    ErasureCodeImpl::encode_arena(ctx, arena, parallel);
 
-    prepare_encode_pointers(buffer, block_size, K, result, data_ptrs, parity_ptrs);
+    return arena;
+}
 
-    // 执行编码
-    perform_encode(block_size, K, N, data_ptrs, parity_ptrs);
+auto encode_streaming(const Context& ctx, BytesSpan data, const StripeSink& sink)
+    -> std::expected<ShardArena, std::error_code>
+{
+    if (data.size() > UINT32_MAX) {
+        return std::unexpected(std::make_error_code(std::errc::file_too_large));
+    }
 
-    return result;
+    ShardArena arena = ErasureCodeImpl::allocate_arena(ctx.N(), ErasureCodeImpl::block_size_for(ctx, data.size()));
+    ErasureCodeImpl::encode_arena_streaming(ctx, arena, data, sink);
+    return arena;
 }
 
-auto decode(const Context& ctx, const std::map<int, std::vector<Byte>>& received_shards)
-    -> std::expected<std::vector<Byte>, std::error_code>
+auto encode_batch(const Context& ctx, std::span<const BytesSpan> payloads, const ParallelFor& parallel)
+    -> std::expected<std::vector<ShardArena>, std::error_code>
 {
     int K = ctx.K();
     int N = ctx.N();
 
-    // 参数验证
-    if (received_shards.size() < static_cast<size_t>(K)) {
-        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    // 各载荷在每个分片行内依次排列，起点按 SHARD_ALIGNMENT 对齐
+    std::vector<size_t> offsets;
+    std::vector<size_t> block_sizes;
+    offsets.reserve(payloads.size());
+    block_sizes.reserve(payloads.size());
+
+    size_t row_size = 0;
+    for (BytesSpan data : payloads) {
+        if (data.size() > UINT32_MAX) {
+            return std::unexpected(std::make_error_code(std::errc::file_too_large));
+        }
+        offsets.push_back(row_size);
+        block_sizes.push_back(ErasureCodeImpl::block_size_for(ctx, data.size()));
+        row_size += align_up(block_sizes.back(), SHARD_ALIGNMENT);
     }
 
-    // 获取块大小
-    size_t block_size = received_shards.begin()->second.size();
-    if (block_size == 0)
-        return std::vector<Byte> {};
+    if (payloads.empty()) {
+        return std::vector<ShardArena> {};
+    }
 
-    // 验证所有块大小一致
-    for (const auto& [_, shard] : received_shards) {
-        if (shard.size() != block_size) {
-            return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    ShardArena rows = ErasureCodeImpl::allocate_arena(N, row_size);
+
+    std::vector<ShardArena> result;
+    result.reserve(payloads.size());
+    for (size_t j = 0; j < payloads.size(); ++j) {
+        result.push_back(ErasureCodeImpl::slice(rows, offsets[j], block_sizes[j]));
+        ErasureCodeImpl::fill_data_shards(result.back(), K, payloads[j]);
+
+        // 对齐间隙同样参与编码，清零以免读取未初始化内存
+        size_t gap_begin = offsets[j] + block_sizes[j];
+        size_t gap_end = j + 1 < payloads.size() ? offsets[j + 1] : row_size;
+        for (int i = 0; i < K; ++i) {
+            std::memset(ErasureCodeImpl::shard_ptr(rows, i) + gap_begin, 0, gap_end - gap_begin);
         }
     }
 
-    // 收集块指针并检查是否为恒等式
-    std::vector<unsigned char*> decode_ptrs(K);
-    auto [is_identity, decode_indexes] = collect_decode_shards(
-        received_shards, K, block_size, decode_ptrs);
+    // 列之间互不相关：对整行一次编码即得到每个载荷各自的校验
+    ErasureCodeImpl::encode_arena(ctx, rows, parallel);
 
-    // 准备最终指针
-    std::vector<unsigned char*> final_ptrs(K);
-    std::vector<std::vector<Byte>> recovered_buffers;
+    return result;
+}
 
-    if (is_identity) {
-        // Fast Path：已是原始数据，直接使用
-        final_ptrs = decode_ptrs;
-    } else {
-        // Slow Path：需要矩阵求逆恢复
-        auto result = perform_matrix_inversion_decode(
-            decode_indexes, decode_ptrs, block_size, K, N, final_ptrs, recovered_buffers);
-        if (!result) {
-            return std::unexpected(result.error());
+auto encode(const Context& ctx, BytesSpan data, const ParallelFor& parallel)
+    -> std::expected<std::vector<std::vector<Byte>>, std::error_code>
+{
+    auto arena = encode_to_arena(ctx, data, parallel);
+    if (!arena) {
+        return std::unexpected(arena.error());
+    }
+
+    std::vector<std::vector<Byte>> result;
+    result.reserve(arena->size());
+    for (BytesSpan shard : arena->views()) {
+        result.emplace_back(shard.begin(), shard.end());
+    }
+    return result;
+}
+
+size_t max_decoded_size(const Context& ctx, size_t block_size) noexcept
+{
+    size_t total_len = static_cast<size_t>(ctx.K()) * block_size;
+    return total_len < LEN_PREFIX_SIZE ? 0 : total_len - LEN_PREFIX_SIZE;
+}
+
+auto decode(const Context& ctx, std::span<const ShardView> shards, MutableBytesSpan output,
+    const ParallelFor& parallel)
+    -> std::expected<size_t, std::error_code>
+{
+    int K = ctx.K();
+
+    // 验证索引范围与块大小一致，并按索引去重
+    auto received = index_shards(ctx, shards);
+    if (!received) {
+        return std::unexpected(received.error());
+    }
+    const size_t block_size = received->block_size;
+    const auto& by_index = received->by_index;
+    if (block_size == 0)
+        return 0;
+
+    std::vector<const unsigned char*> blocks(by_index.begin(), by_index.begin() + K);
+    std::vector<Byte> recovered;
+
+    std::vector<int> missing;
+    for (int i = 0; i < K; ++i) {
+        if (blocks[i] == nullptr)
+            missing.push_back(i);
+    }
+
+    if (!missing.empty()) {
+        const int e = static_cast<int>(missing.size());
+        recovered.resize(e * block_size);
+        std::vector<unsigned char*> recovered_ptrs(e);
+        for (int i = 0; i < e; ++i) {
+            recovered_ptrs[i] = u8ptr(recovered.data() + (i * block_size));
+            blocks[missing[i]] = recovered_ptrs[i];
+        }
+
+        if (ctx.backend() == Backend::Gf16Fft) {
+            ErasureCodeImpl::recover_fft(ctx, block_size, by_index, missing, recovered_ptrs, parallel);
+        } else {
+            // Slow Path：保留已到达的数据分片，以最前面的 e 个校验分片只恢复缺失的数据块
+            std::vector<int> decode_indexes = gf8_decode_indexes(*received, K);
+            std::vector<unsigned char*> decode_ptrs;
+            for (int idx : decode_indexes) {
+                decode_ptrs.push_back(const_cast<unsigned char*>(by_index[idx]));
+            }
+
+            auto g_tbls = ErasureCodeImpl::decode_tables(ctx, decode_indexes, missing);
+            if (!g_tbls) {
+                return std::unexpected(g_tbls.error());
+            }
+
+            striped_encode_data(parallel, block_size, K, e, (*g_tbls)->data(),
+                decode_ptrs.data(), recovered_ptrs.data());
         }
     }
 
-    // 从恢复的块中提取原始数据
-    return extract_original_data(final_ptrs, K, block_size);
+    // 已到达的数据分片直接拷贝到输出；数据分片齐全时即为 Fast Path
+    return extract_original_data(blocks, block_size, output);
+}
+
+auto reencode_streaming(const Context& ctx, std::span<const ShardView> shards, MutableBytesSpan output,
+    const ShardsStripeSink& sink)
+    -> std::expected<size_t, std::error_code>
+{
+    auto received = index_shards(ctx, shards);
+    if (!received) {
+        return std::unexpected(received.error());
+    }
+    return ErasureCodeImpl::reencode(ctx, *received, output, sink);
+}
+
+auto decode(const Context& ctx, const std::map<int, std::vector<Byte>>& received_shards,
+    const ParallelFor& parallel)
+    -> std::expected<std::vector<Byte>, std::error_code>
+{
+    // 参数验证
+    if (received_shards.size() < static_cast<size_t>(ctx.K())) {
+        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+
+    std::vector<ShardView> views;
+    views.reserve(received_shards.size());
+    for (const auto& [idx, shard] : received_shards) {
+        views.push_back({ .index = idx, .data = shard });
+    }
+
+    std::vector<Byte> output(max_decoded_size(ctx, received_shards.begin()->second.size()));
+    auto len = decode(ctx, views, output, parallel);
+    if (!len) {
+        return std::unexpected(len.error());
+    }
+    output.resize(*len);
+    return output;
 }
 
 // --- Context Implementation ---
 
-std::expected<Context, std::error_code> Context::create(int K, int N)
+Context::Context(int K, int N, std::vector<unsigned char>&& encode_matrix,
+    std::vector<unsigned char>&& parity_g_tbls,
+    std::unique_ptr<DecodeTableCache>&& decode_cache)
+    : K_(K)
+    , N_(N)
+    , encode_matrix_(std::move(encode_matrix))
+    , parity_g_tbls_(std::move(parity_g_tbls))
+    , decode_cache_(std::move(decode_cache))
+{
+}
+
+Context::Context(Context&&) noexcept = default;
+Context& Context::operator=(Context&&) noexcept = default;
+Context::~Context() = default;
+
+Backend Context::backend() const noexcept
 {
-    if (K <= 0 || N <= K) {
+    return fft_codec_ ? Backend::Gf16Fft : Backend::Gf8Cauchy;
+}
+
+size_t Context::cached_decode_tables() const noexcept
+{
+    return decode_cache_ ? decode_cache_->size() : 0;
+}
+
+std::expected<Context, std::error_code> Context::create(int K, int N, size_t decode_cache_capacity)
+{
+    return create(K, N, Backend::Gf8Cauchy, decode_cache_capacity);
+}
+
+std::expected<Context, std::error_code> Context::create(int K, int N, Backend backend, size_t decode_cache_capacity)
+{
+    if (backend == Backend::Gf16Fft) {
+        if (!Gf16Codec::supports(K, N)) {
+            return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+        }
+
+        Context ctx(K, N, {}, {}, nullptr);
+        ctx.fft_codec_ = std::make_unique<Gf16Codec>(K, N);
+        return ctx;
+    }
+
+    // GF(2^8) 柯西矩阵最多支持 255 个分片
+    if (K <= 0 || N <= K || N > 255) {
         return std::unexpected(std::make_error_code(std::errc::invalid_argument));
     }
 
@@ -312,18 +916,10 @@ std::expected<Context, std::error_code> Context::create(int K, int N)
     std::vector<unsigned char> parity_g_tbls((N - K) * K * 32);
     ec_init_tables(K, N - K, parity_matrix, parity_g_tbls.data());
 
-    // 初始化解码表（用于解码）
-    // 这里用单位矩阵作为示例，实际解码时会根据接收到的块索引重新计算
-    std::vector<unsigned char> decode_matrix(K * K);
-    for (int i = 0; i < K; ++i) {
-        for (int j = 0; j < K; ++j) {
-            decode_matrix[i * K + j] = (i == j) ? 1 : 0;
-        }
-    }
-    std::vector<unsigned char> decode_g_tbls(K * K * 32);
-    ec_init_tables(K, K, decode_matrix.data(), decode_g_tbls.data());
+    // 解码表按接收到的分片集合按需生成并缓存
+    auto decode_cache = std::make_unique<DecodeTableCache>(decode_cache_capacity);
 
-    return Context(K, N, std::move(encode_matrix), std::move(parity_g_tbls), std::move(decode_g_tbls));
+    return Context(K, N, std::move(encode_matrix), std::move(parity_g_tbls), std::move(decode_cache));
 }
 
 } // namespace Honey::Crypto::ErasureCode
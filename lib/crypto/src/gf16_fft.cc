@@ -0,0 +1,355 @@
+#include "gf16_fft.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <memory>
+
+namespace Honey::Crypto::ErasureCode {
+
+namespace {
+
+    using Symbol = std::uint16_t;
+
+    constexpr unsigned BITS = 16;
+    constexpr unsigned ORDER = 1U << BITS;
+    // 乘法群的阶，对数运算均模此数
+    constexpr unsigned MODULUS = ORDER - 1;
+    // x^16 + x^5 + x^3 + x^2 + 1
+    constexpr unsigned POLYNOMIAL = 0x1002D;
+
+    // --- Field Tables ---
+
+    /**
+     * 取标准基 v_b = 2^b，V_j = span(v_0..v_{j-1})，ω_r 即整数 r 对应的域元素。
+     * W_j(x) = Π_{a∈V_j}(x - a) 是线性化多项式，Ŵ_j = W_j / W_j(v_j)，
+     * novel basis 为 X_i = Π_{j∈bits(i)} Ŵ_j。
+     */
+    struct Tables {
+        std::array<Symbol, ORDER> log; // log[0] = MODULUS 表示零
+        std::array<Symbol, 2 * ORDER> exp; // 加倍以免对数相加后取模
+        std::array<Symbol, ORDER - 1> skew; // log Ŵ_j(ω_r)，r 为 2^{j+1} 的倍数
+        std::array<Symbol, BITS> derivative; // log Ŵ_j'，Ŵ_j 的导数为常数
+    };
+
+    Symbol mul(const Tables& t, Symbol a, Symbol b)
+    {
+        if (a == 0 || b == 0)
+            return 0;
+        return t.exp[t.log[a] + t.log[b]];
+    }
+
+    // 第 j 层、偏移 r 处的 skew 在表中的位置，各层依次存放
+    size_t skew_index(unsigned j, size_t r)
+    {
+        return (ORDER - (ORDER >> j)) + (r >> (j + 1));
+    }
+
+    std::unique_ptr<const Tables> build_tables()
+    {
+        auto t = std::make_unique<Tables>();
+
+        unsigned x = 1;
+        for (unsigned i = 0; i < MODULUS; ++i) {
+            t->exp[i] = static_cast<Symbol>(x);
+            t->log[x] = static_cast<Symbol>(i);
+            x <<= 1;
+            if ((x & ORDER) != 0)
+                x ^= POLYNOMIAL;
+        }
+        for (unsigned i = MODULUS; i < 2 * ORDER; ++i) {
+            t->exp[i] = t->exp[i - MODULUS];
+        }
+        t->log[0] = MODULUS;
+
+        // W_{j+1}(x) = W_j(x)·(W_j(x) + W_j(v_j))
+        std::array<Symbol, BITS> w_v {};
+        auto eval_w = [&](unsigned j, Symbol v) {
+            for (unsigned i = 0; i < j; ++i) {
+                v = mul(*t, v, v ^ w_v[i]);
+            }
+            return v;
+        };
+        for (unsigned j = 0; j < BITS; ++j) {
+            w_v[j] = eval_w(j, static_cast<Symbol>(1U << j));
+        }
+
+        // Ŵ_j 是 F2-线性的，ω_r 处的取值为 r 各位对应基元素取值的异或
+        for (unsigned j = 0; j < BITS; ++j) {
+            Symbol inv = t->exp[MODULUS - t->log[w_v[j]]];
+            std::array<Symbol, BITS> basis {};
+            for (unsigned b = j + 1; b < BITS; ++b) {
+                basis[b] = mul(*t, eval_w(j, static_cast<Symbol>(1U << b)), inv);
+            }
+
+            size_t count = ORDER >> (j + 1);
+            std::vector<Symbol> value(count, 0);
+            for (size_t q = 1; q < count; ++q) {
+                value[q] = value[q & (q - 1)] ^ basis[j + 1 + std::countr_zero(q)];
+            }
+            for (size_t q = 0; q < count; ++q) {
+                t->skew[skew_index(j, q << (j + 1))] = t->log[value[q]];
+            }
+        }
+
+        // W_j' = Π_{i<j} W_i(v_i)，故 Ŵ_j' = W_j' / W_j(v_j)
+        unsigned log_w_prime = 0;
+        for (unsigned j = 0; j < BITS; ++j) {
+            unsigned log_w_v = t->log[w_v[j]];
+            t->derivative[j] = static_cast<Symbol>((log_w_prime + MODULUS - log_w_v) % MODULUS);
+            log_w_prime = (log_w_prime + log_w_v) % MODULUS;
+        }
+
+        return t;
+    }
+
+    const Tables& tables()
+    {
+        static const std::unique_ptr<const Tables> instance = build_tables();
+        return *instance;
+    }
+
+    // --- Row Operations ---
+
+    // 每行为一段列条带上的 cols 个符号
+    void load_row(Symbol* dst, const unsigned char* src, size_t cols)
+    {
+        for (size_t i = 0; i < cols; ++i) {
+            dst[i] = static_cast<Symbol>(src[2 * i] | (src[(2 * i) + 1] << 8));
+        }
+    }
+
+    void store_row(unsigned char* dst, const Symbol* src, size_t cols)
+    {
+        for (size_t i = 0; i < cols; ++i) {
+            dst[2 * i] = static_cast<unsigned char>(src[i]);
+            dst[(2 * i) + 1] = static_cast<unsigned char>(src[i] >> 8);
+        }
+    }
+
+    void xor_into(Symbol* dst, const Symbol* src, size_t cols)
+    {
+        for (size_t i = 0; i < cols; ++i) {
+            dst[i] ^= src[i];
+        }
+    }
+
+    // dst ^= c·src，c 以对数给出
+    void mul_add(const Tables& t, Symbol* dst, const Symbol* src, unsigned log_c, size_t cols)
+    {
+        for (size_t i = 0; i < cols; ++i) {
+            if (src[i] != 0)
+                dst[i] ^= t.exp[t.log[src[i]] + log_c];
+        }
+    }
+
+    void mul_in_place(const Tables& t, Symbol* row, unsigned log_c, size_t cols)
+    {
+        for (size_t i = 0; i < cols; ++i) {
+            if (row[i] != 0)
+                row[i] = t.exp[t.log[row[i]] + log_c];
+        }
+    }
+
+    // --- Transforms ---
+
+    /**
+     * @brief novel basis 系数 → 陪集 ω_base + V_k 上的取值（size = 2^k，base 为 size 的倍数）
+     *
+     * f = g0 + Ŵ_j·g1，Ŵ_j 在前半陪集上恒为 s = Ŵ_j(ω_r)，后半为 s + 1，
+     * 因此 a = g0 + s·g1、b = a + g1 后分别递归。
+     */
+    void fft(const Tables& t, Symbol* work, size_t cols, size_t size, size_t base)
+    {
+        for (size_t width = size / 2; width >= 1; width /= 2) {
+            auto j = static_cast<unsigned>(std::countr_zero(width));
+            for (size_t r = 0; r < size; r += 2 * width) {
+                unsigned log_s = t.skew[skew_index(j, base + r)];
+                for (size_t k = 0; k < width; ++k) {
+                    Symbol* a = work + ((r + k) * cols);
+                    Symbol* b = a + (width * cols);
+                    if (log_s != MODULUS)
+                        mul_add(t, a, b, log_s, cols);
+                    xor_into(b, a, cols);
+                }
+            }
+        }
+    }
+
+    // fft 的逆变换：取值 → novel basis 系数
+    void ifft(const Tables& t, Symbol* work, size_t cols, size_t size, size_t base)
+    {
+        for (size_t width = 1; width < size; width *= 2) {
+            auto j = static_cast<unsigned>(std::countr_zero(width));
+            for (size_t r = 0; r < size; r += 2 * width) {
+                unsigned log_s = t.skew[skew_index(j, base + r)];
+                for (size_t k = 0; k < width; ++k) {
+                    Symbol* a = work + ((r + k) * cols);
+                    Symbol* b = a + (width * cols);
+                    xor_into(b, a, cols);
+                    if (log_s != MODULUS)
+                        mul_add(t, a, b, log_s, cols);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief novel basis 下的形式导数：X_i' = Σ_{j∈bits(i)} Ŵ_j'·X_{i⊕2^j}
+     *
+     * 按 Leopard 的顺序原地计算：每一行在作为目标被修改之前已经用完了作为源的全部贡献。
+     */
+    void formal_derivative(const Tables& t, Symbol* work, size_t cols, size_t size)
+    {
+        for (size_t i = 1; i < size; ++i) {
+            size_t width = i & (~i + 1);
+            unsigned log_c = t.derivative[std::countr_zero(i)];
+            for (size_t k = 0; k < width; ++k) {
+                mul_add(t, work + ((i - width + k) * cols), work + ((i + k) * cols), log_c, cols);
+            }
+        }
+    }
+
+    // XOR 群上的 Walsh–Hadamard 变换，模 MODULUS
+    void fwht(std::vector<uint32_t>& v)
+    {
+        for (size_t width = 1; width < v.size(); width *= 2) {
+            for (size_t r = 0; r < v.size(); r += 2 * width) {
+                for (size_t k = r; k < r + width; ++k) {
+                    uint32_t x = v[k];
+                    uint32_t y = v[k + width];
+                    v[k] = (x + y) % MODULUS;
+                    v[k + width] = (x + MODULUS - y) % MODULUS;
+                }
+            }
+        }
+    }
+
+} // namespace
+
+bool Gf16Codec::supports(int K, int N) noexcept
+{
+    if (K <= 0 || N <= K)
+        return false;
+    return std::bit_ceil(static_cast<unsigned>(N - K)) + static_cast<unsigned>(K) <= ORDER;
+}
+
+Gf16Codec::Gf16Codec(int K, int N)
+    : K_(K)
+    , R_(N - K)
+    , m_(std::bit_ceil(static_cast<size_t>(N - K)))
+    , n_(std::bit_ceil(m_ + K))
+{
+    tables();
+}
+
+const unsigned char* Gf16Codec::shard_at(
+    std::span<const unsigned char* const> shards, size_t p) const noexcept
+{
+    if (p < static_cast<size_t>(R_))
+        return shards[K_ + p];
+    if (p >= m_ && p < m_ + K_)
+        return shards[p - m_];
+    return nullptr;
+}
+
+void Gf16Codec::encode(size_t offset, size_t len,
+    std::span<unsigned char* const> data,
+    std::span<unsigned char* const> parity) const
+{
+    const Tables& t = tables();
+    const size_t cols = len / 2;
+    const auto K = static_cast<size_t>(K_);
+
+    // 每 m 个数据块为一组，在其陪集上插值后累加，再在校验陪集上求值
+    std::vector<Symbol> work(m_ * cols, 0);
+    std::vector<Symbol> temp(K > m_ ? m_ * cols : 0);
+
+    for (size_t first = 0; first < K; first += m_) {
+        Symbol* target = first == 0 ? work.data() : temp.data();
+        size_t rows = std::min(m_, K - first);
+        for (size_t i = 0; i < rows; ++i) {
+            load_row(target + (i * cols), data[first + i] + offset, cols);
+        }
+        std::fill(target + (rows * cols), target + (m_ * cols), 0);
+
+        ifft(t, target, cols, m_, m_ + first);
+        if (first != 0)
+            xor_into(work.data(), temp.data(), m_ * cols);
+    }
+
+    fft(t, work.data(), cols, m_, 0);
+
+    for (int p = 0; p < R_; ++p) {
+        store_row(parity[p] + offset, work.data() + (p * cols), cols);
+    }
+}
+
+std::vector<std::uint16_t> Gf16Codec::error_locator(
+    std::span<const unsigned char* const> shards) const
+{
+    const Tables& t = tables();
+
+    // 未输出的校验位置 [R, m) 总是视为擦除，零填充位置已知为零
+    std::vector<uint32_t> erased(n_, 0);
+    for (size_t p = 0; p < m_ + K_; ++p) {
+        erased[p] = shard_at(shards, p) == nullptr ? 1 : 0;
+    }
+
+    // loc[p] = Σ_{i∈E} log(ω_p ⊕ ω_i)，log(0) 记为 0，即 XOR 卷积
+    std::vector<uint32_t> logs(n_);
+    logs[0] = 0;
+    for (size_t p = 1; p < n_; ++p) {
+        logs[p] = t.log[p];
+    }
+
+    fwht(erased);
+    fwht(logs);
+    for (size_t p = 0; p < n_; ++p) {
+        erased[p] = static_cast<uint32_t>((static_cast<uint64_t>(erased[p]) * logs[p]) % MODULUS);
+    }
+    fwht(erased);
+
+    // 2^16 ≡ 1 (mod MODULUS)，故 1/n = 2^16 / n
+    const uint64_t inv_n = (ORDER / n_) % MODULUS;
+    std::vector<std::uint16_t> locator(n_);
+    for (size_t p = 0; p < n_; ++p) {
+        locator[p] = static_cast<std::uint16_t>((erased[p] * inv_n) % MODULUS);
+    }
+    return locator;
+}
+
+void Gf16Codec::decode(size_t offset, size_t len,
+    std::span<const std::uint16_t> locator,
+    std::span<const unsigned char* const> shards,
+    std::span<const int> missing,
+    std::span<unsigned char* const> recovered) const
+{
+    const Tables& t = tables();
+    const size_t cols = len / 2;
+
+    // 收到的取值乘以 e(ω_p)，擦除位置为零：得到 e·f 的全部取值
+    std::vector<Symbol> work(n_ * cols, 0);
+    for (size_t p = 0; p < m_ + K_; ++p) {
+        const unsigned char* shard = shard_at(shards, p);
+        if (shard == nullptr)
+            continue;
+
+        Symbol* row = work.data() + (p * cols);
+        load_row(row, shard + offset, cols);
+        mul_in_place(t, row, locator[p], cols);
+    }
+
+    // (e·f)' 在擦除点处等于 e'·f
+    ifft(t, work.data(), cols, n_, 0);
+    formal_derivative(t, work.data(), cols, n_);
+    fft(t, work.data(), cols, n_, 0);
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+        size_t p = m_ + missing[i];
+        Symbol* row = work.data() + (p * cols);
+        mul_in_place(t, row, MODULUS - locator[p], cols);
+        store_row(recovered[i] + offset, row, cols);
+    }
+}
+
+} // namespace Honey::Crypto::ErasureCode
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Honey::Crypto::ErasureCode {
+
+/**
+ * @brief GF(2^16) 上基于加性 FFT 的 Reed–Solomon 编解码（Lin–Chung–Han / Leopard 方案）
+ *
+ * 码字位置布局：[0, m) 为校验（m = bit_ceil(N-K)，只输出前 N-K 个），[m, m+K) 为数据，
+ * [m+K, n) 为恒零填充（n = bit_ceil(m+K)）。码字是一个次数 < n-m 的多项式在
+ * ω_0..ω_{n-1} 上的取值，任意 K 个真实分片即可恢复。
+ *
+ * 每个分片按 16 位小端符号解释，因此块大小必须为偶数。各列互不相关，所有接口
+ * 都只处理块内 [offset, offset+len) 的一段列条带。
+ */
+class Gf16Codec {
+public:
+    /// 位置数 m+K 不能超过域的大小
+    [[nodiscard]] static bool supports(int K, int N) noexcept;
+
+    Gf16Codec(int K, int N);
+
+    /// 解码时每列参与变换的行数，用于确定条带宽度
+    [[nodiscard]] std::size_t rows() const noexcept { return n_; }
+
+    /**
+     * @brief 由 K 个数据块计算 N-K 个校验块的一段列条带
+     */
+    void encode(std::size_t offset, std::size_t len,
+        std::span<unsigned char* const> data,
+        std::span<unsigned char* const> parity) const;
+
+    /**
+     * @brief 计算各位置上错误定位多项式取值的对数
+     *
+     * shards 按分片索引给出（缺失为 nullptr）。非擦除位置为 log e(ω_p)，
+     * 擦除位置为 log e'(ω_p)，与列条带无关，只需计算一次。
+     */
+    [[nodiscard]] std::vector<std::uint16_t> error_locator(
+        std::span<const unsigned char* const> shards) const;
+
+    /**
+     * @brief 恢复缺失数据块的一段列条带，recovered[i] 对应数据分片 missing[i]
+     */
+    void decode(std::size_t offset, std::size_t len,
+        std::span<const std::uint16_t> locator,
+        std::span<const unsigned char* const> shards,
+        std::span<const int> missing,
+        std::span<unsigned char* const> recovered) const;
+
+private:
+    int K_;
+    int R_;
+    std::size_t m_;
+    std::size_t n_;
+
+    // 码字位置 p 对应的分片（未输出的校验与零填充位置为 nullptr）
+    [[nodiscard]] const unsigned char* shard_at(
+        std::span<const unsigned char* const> shards, std::size_t p) const noexcept;
+};
+
+} // namespace Honey::Crypto::ErasureCode
@@ -1,8 +1,9 @@
 #include "crypto/merkle_tree.hpp"
-#include "threshold/utils.hpp"
-#include <bit>
-#include <cstring>
-#include <openssl/evp.h>
+#include "sha256_mb.hpp"
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
 
 namespace Honey::Crypto::MerkleTree {
 
@@ -10,126 +11,449 @@ namespace {
     constexpr Byte LEAF_PREFIX { 0x00 };
     constexpr Byte INTERNAL_PREFIX { 0x01 };
 
-    std::expected<Hash, std::error_code> hash_leaf(EVP_MD_CTX* ctx, BytesSpan data)
+    // A multiple of every SHA-256 kernel's lane count
+    constexpr size_t JOB_CHUNK = 64;
+
+    impl::Sha256Job leaf_job(BytesSpan data, Hash& out)
+    {
+        return { .parts = { BytesSpan(&LEAF_PREFIX, 1), data, {} }, .digest = out.data() };
+    }
+
+    // `children` are adjacent in memory, so a node of any arity is one part
+    impl::Sha256Job internal_job(std::span<const Hash> children, Hash& out)
+    {
+        return { .parts = { BytesSpan(&INTERNAL_PREFIX, 1), std::as_bytes(children), {} }, .digest = out.data() };
+    }
+
+    Hash hash_leaf(BytesSpan data)
     {
         Hash h;
-        unsigned int len = 0;
-        if (1 != EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) || 1 != EVP_DigestUpdate(ctx, u8ptr(&LEAF_PREFIX), 1) || 1 != EVP_DigestUpdate(ctx, u8ptr(data), data.size()) || 1 != EVP_DigestFinal_ex(ctx, u8ptr(h.data()), &len)) {
-            return std::unexpected(std::make_error_code(std::errc::io_error));
-        }
+        impl::sha256_one(leaf_job(data, h));
         return h;
     }
 
-    std::expected<Hash, std::error_code> hash_internal(EVP_MD_CTX* ctx, const Hash& left, const Hash& right)
+    Hash hash_children(std::span<const Hash> children)
     {
         Hash h;
-        unsigned int len;
-        if (1 != EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) || 1 != EVP_DigestUpdate(ctx, u8ptr(&INTERNAL_PREFIX), 1) || 1 != EVP_DigestUpdate(ctx, left.data(), left.size()) || 1 != EVP_DigestUpdate(ctx, right.data(), right.size()) || 1 != EVP_DigestFinal_ex(ctx, u8ptr(h.data()), &len)) {
-            return std::unexpected(std::make_error_code(std::errc::io_error));
-        }
+        impl::sha256_one(internal_job(children, h));
         return h;
     }
 
+    // Arity^depth, or 0 if it (or the batch verifier's key space above it)
+    // does not fit in size_t
+    template <size_t Arity>
+    size_t padded_count(size_t depth) noexcept
+    {
+        size_t p = 1;
+        for (size_t d = 0; d < depth; ++d) {
+            if (p > std::numeric_limits<size_t>::max() / (2 * Arity))
+                return 0;
+            p *= Arity;
+        }
+        return p;
+    }
+
 } // namespace
 
-Tree Tree::build(std::vector<std::vector<Byte>>&& leaves)
+template <size_t Arity>
+BasicTree<Arity> BasicTree<Arity>::build(std::vector<std::vector<Byte>>&& leaves)
+{
+    auto owned = std::make_shared<std::vector<std::vector<Byte>>>(std::move(leaves));
+    std::vector<BytesSpan> views(owned->begin(), owned->end());
+    return build(views, std::move(owned));
+}
+
+template <size_t Arity>
+BasicTree<Arity> BasicTree<Arity>::build(std::span<const BytesSpan> leaves, std::shared_ptr<const void> owner)
+{
+    BasicTree tree;
+    tree.views_.assign(leaves.begin(), leaves.end());
+    tree.count_ = leaves.size();
+    tree.owner_ = std::move(owner);
+    tree.hash_nodes({});
+    return tree;
+}
+
+template <size_t Arity>
+BasicTree<Arity> BasicTree<Arity>::build(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner)
 {
-    Tree tree;
-    tree.leaves_ = std::move(leaves);
+    BasicTree tree = striped(buffer, stripe_size, stride, std::move(owner));
+    tree.hash_nodes({});
+    return tree;
+}
 
-    if (tree.leaves_.empty()) {
-        return tree;
+template <size_t Arity>
+BasicTree<Arity> BasicTree<Arity>::build(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner,
+    std::span<const Hash> leaf_hashes)
+{
+    BasicTree tree = striped(buffer, stripe_size, stride, std::move(owner));
+    if (leaf_hashes.size() != tree.count_) {
+        throw std::invalid_argument("Merkle leaf hashes do not match the stripe count");
     }
+    tree.hash_nodes(leaf_hashes);
+    return tree;
+}
 
-    impl::EvpMdCtxPtr ctx(EVP_MD_CTX_new());
-    if (!ctx)
-        return {};
+template <size_t Arity>
+Hash BasicTree<Arity>::root_of(std::span<const Hash> leaf_hashes)
+{
+    BasicTree tree;
+    tree.count_ = leaf_hashes.size();
+    tree.hash_nodes(leaf_hashes);
+    return tree.root_hash_;
+}
 
-    const size_t N = tree.leaves_.size();
-    const size_t P = std::bit_ceil(N);
-    tree.nodes_.resize(2 * P);
+template <size_t Arity>
+BasicTree<Arity> BasicTree<Arity>::striped(BytesSpan buffer, size_type stripe_size, size_type stride, std::shared_ptr<const void> owner)
+{
+    if (stripe_size == 0 || stride < stripe_size) {
+        throw std::invalid_argument("Merkle stripe size must be non-zero and at most the stride");
+    }
 
-    // 1. Hash actual leaves
-    for (size_t i = 0; i < N; ++i) {
-        auto res = hash_leaf(ctx.get(), tree.leaves_[i]);
-        if (!res)
-            return {};
-        tree.nodes_[P + i] = *res;
+    BasicTree tree;
+    if (!buffer.empty()) {
+        if (buffer.size() < stripe_size || (buffer.size() - stripe_size) % stride != 0) {
+            throw std::invalid_argument("Merkle buffer is not a whole number of stripes");
+        }
+        tree.count_ = ((buffer.size() - stripe_size) / stride) + 1;
+    }
+    tree.base_ = buffer.data();
+    tree.stripe_size_ = stripe_size;
+    tree.stride_ = stride;
+    tree.owner_ = std::move(owner);
+    return tree;
+}
+
+template <size_t Arity>
+auto BasicTree<Arity>::level_offset(size_type level) const noexcept -> size_type
+{
+    // P + P/Arity + ... + P/Arity^(level-1)
+    size_type width = padded_count_;
+    for (size_type l = 0; l < level; ++l) {
+        width /= Arity;
+    }
+    return (padded_count_ - width) / (Arity - 1) * Arity;
+}
+
+template <size_t Arity>
+void BasicTree<Arity>::hash_nodes(std::span<const Hash> leaf_hashes)
+{
+    if (count_ == 0) {
+        return;
+    }
+
+    const size_t N = count_;
+    padded_count_ = 1;
+    depth_ = 0;
+    while (padded_count_ < N) {
+        padded_count_ *= Arity;
+        ++depth_;
+    }
+    const size_t P = padded_count_;
+    nodes_.resize(level_offset(depth_) + 1);
+
+    // Jobs go to the hasher in fixed chunks so no scratch vector is needed
+    std::array<impl::Sha256Job, JOB_CHUNK> jobs {};
+
+    // 1. Hash actual leaves, several lanes at a time, unless the caller
+    //    already did while producing them
+    if (!leaf_hashes.empty()) {
+        std::ranges::copy(leaf_hashes, nodes_.begin());
+    }
+    for (size_t first = 0; leaf_hashes.empty() && first < N; first += JOB_CHUNK) {
+        const size_t n = std::min(JOB_CHUNK, N - first);
+        for (size_t j = 0; j < n; ++j) {
+            jobs[j] = leaf_job(leaf_unchecked(first + j), nodes_[first + j]);
+        }
+        impl::sha256_many(std::span(jobs).first(n));
     }
 
     // 2. Hash padding leaves
     if (N < P) {
-        auto res = hash_leaf(ctx.get(), {});
-        if (!res)
-            return {};
+        Hash padding = hash_leaf({});
         for (size_t i = N; i < P; ++i) {
-            tree.nodes_[P + i] = *res;
+            nodes_[i] = padding;
+        }
+    }
+
+    // 3. Hash internal nodes level by level; nodes of one level are independent
+    size_t child_offset = 0;
+    for (size_t level = 1, width = P / Arity; level <= depth_; ++level, width /= Arity) {
+        const size_t offset = level_offset(level);
+        for (size_t first = 0; first < width; first += JOB_CHUNK) {
+            const size_t n = std::min(JOB_CHUNK, width - first);
+            for (size_t j = 0; j < n; ++j) {
+                const size_t i = first + j;
+                jobs[j] = internal_job(std::span(nodes_).subspan(child_offset + (i * Arity), Arity), nodes_[offset + i]);
+            }
+            impl::sha256_many(std::span(jobs).first(n));
         }
+        child_offset = offset;
     }
 
-    // 3. Hash internal nodes
-    for (size_t i = P - 1; i > 0; --i) {
-        auto res = hash_internal(ctx.get(), tree.nodes_[2 * i], tree.nodes_[(2 * i) + 1]);
-        if (!res)
-            return {};
-        tree.nodes_[i] = *res;
+    root_hash_ = nodes_.back();
+}
+
+template <size_t Arity>
+std::expected<BasicProof<Arity>, std::error_code> BasicTree<Arity>::prove(size_type leaf_index) const
+{
+    if (leaf_index >= count_) {
+        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+    if (depth_ * (Arity - 1) > MAX_PROOF_SIBLINGS<Arity>) {
+        return std::unexpected(std::make_error_code(std::errc::value_too_large));
     }
 
-    if (!tree.nodes_.empty()) {
-        tree.root_hash_ = tree.nodes_[1];
+    BasicProof<Arity> proof { .leaf_index = leaf_index, .siblings = {} };
+
+    size_t j = leaf_index;
+    for (size_t level = 0; level < depth_; ++level, j /= Arity) {
+        const size_t first = j - (j % Arity);
+        for (size_t c = first; c < first + Arity; ++c) {
+            if (c != j) {
+                proof.siblings.push_back(node(level, c));
+            }
+        }
     }
 
-    return tree;
+    return proof;
 }
 
-bool verify(BytesSpan leaf, const Proof& proof, const Hash& root) noexcept
+template <size_t Arity>
+std::expected<MultiProof, std::error_code> BasicTree<Arity>::prove(std::span<const size_type> leaf_indices) const
 {
-    impl::EvpMdCtxPtr ctx(EVP_MD_CTX_new());
-    if (!ctx)
-        return false;
+    std::vector<size_t> indices(leaf_indices.begin(), leaf_indices.end());
+    std::ranges::sort(indices);
+    const auto [first, last] = std::ranges::unique(indices);
+    indices.erase(first, last);
+    if (indices.empty() || indices.back() >= count_) {
+        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    }
+
+    MultiProof proof { .depth = depth_, .leaf_indices = indices, .siblings = {} };
+
+    // Walk the covered nodes up one level at a time; each parent needs the
+    // children that are not covered themselves.
+    std::vector<size_t> level = std::move(indices);
+    std::vector<size_t> parents;
+    for (size_t l = 0; l < depth_; ++l) {
+        parents.clear();
+        for (size_t i = 0; i < level.size();) {
+            const size_t parent = level[i] / Arity;
+            for (size_t c = parent * Arity; c < (parent + 1) * Arity; ++c) {
+                if (i < level.size() && level[i] == c) {
+                    ++i;
+                } else {
+                    proof.siblings.push_back(node(l, c));
+                }
+            }
+            parents.push_back(parent);
+        }
+        std::swap(level, parents);
+    }
+    return proof;
+}
 
-    auto acc_res = hash_leaf(ctx.get(), leaf);
-    if (!acc_res)
+template <size_t Arity>
+auto BasicTree<Arity>::leaf(size_type leaf_index) const -> const_reference
+{
+    if (leaf_index >= count_) {
+        throw std::out_of_range("Merkle leaf index out of range");
+    }
+    return leaf_unchecked(leaf_index);
+}
+
+template <size_t Arity>
+bool verify(BytesSpan leaf, const BasicProof<Arity>& proof, const Hash& root) noexcept
+{
+    if (proof.siblings.size() % (Arity - 1) != 0) {
         return false;
+    }
 
-    Hash acc = *acc_res;
+    Hash acc = hash_leaf(leaf);
     size_t idx = proof.leaf_index;
+    std::array<Hash, Arity> children;
 
-    for (const auto& sib : proof.siblings) {
-        std::expected<Hash, std::error_code> next_acc_res;
-        if ((idx & 1) != 0U) { // Current node is a right child
-            next_acc_res = hash_internal(ctx.get(), sib, acc);
-        } else { // Current node is a left child
-            next_acc_res = hash_internal(ctx.get(), acc, sib);
-        }
-        if (!next_acc_res)
-            return false;
-        acc = *next_acc_res;
-        idx >>= 1;
+    for (size_t s = 0; s < proof.siblings.size(); s += Arity - 1) {
+        // Put the current node back between its siblings
+        const size_t pos = idx % Arity;
+        std::copy_n(proof.siblings.begin() + s, pos, children.begin());
+        children[pos] = acc;
+        std::copy_n(proof.siblings.begin() + s + pos, Arity - 1 - pos, children.begin() + pos + 1);
+        acc = hash_children(children);
+        idx /= Arity;
     }
     return acc == root;
 }
 
-std::expected<Proof, std::error_code> Tree::prove(size_type leaf_index) const
+bool verify(BytesSpan leaf, const Proof& proof, const Hash& root) noexcept
 {
-    if (leaf_index >= leaves_.size()) {
-        return std::unexpected(std::make_error_code(std::errc::invalid_argument));
+    return verify<2>(leaf, proof, root);
+}
+
+template <size_t Arity>
+bool verify(std::span<const BytesSpan> leaves, const MultiProof& proof, const Hash& root)
+{
+    const auto& indices = proof.leaf_indices;
+    const size_t padded_leaf_count = padded_count<Arity>(proof.depth);
+    if (indices.empty() || leaves.size() != indices.size() || padded_leaf_count == 0) {
+        return false;
+    }
+    for (size_t i = 0; i < indices.size(); ++i) {
+        if (indices[i] >= padded_leaf_count || (i > 0 && indices[i] <= indices[i - 1])) {
+            return false;
+        }
+    }
+
+    // Current level as (index within the level, hash), ascending
+    std::vector<std::pair<size_t, Hash>> level(indices.size());
+    std::vector<impl::Sha256Job> jobs;
+    jobs.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) {
+        level[i].first = indices[i];
+        jobs.push_back(leaf_job(leaves[i], level[i].second));
+    }
+    impl::sha256_many(jobs);
+
+    std::vector<std::pair<size_t, Hash>> parents;
+    std::vector<Hash> children;
+    size_t next_sibling = 0;
+    for (size_t l = 0; l < proof.depth; ++l) {
+        // Reserved up front, so the pointers handed to the jobs stay valid
+        parents.clear();
+        parents.reserve(level.size());
+        children.clear();
+        children.reserve(level.size() * Arity);
+        jobs.clear();
+        for (size_t i = 0; i < level.size();) {
+            const size_t parent = level[i].first / Arity;
+            const size_t group = children.size();
+            for (size_t c = parent * Arity; c < (parent + 1) * Arity; ++c) {
+                if (i < level.size() && level[i].first == c) {
+                    children.push_back(level[i++].second);
+                } else if (next_sibling < proof.siblings.size()) {
+                    children.push_back(proof.siblings[next_sibling++]);
+                } else {
+                    return false;
+                }
+            }
+            Hash& out = parents.emplace_back(parent, Hash {}).second;
+            jobs.push_back(internal_job(std::span(children).subspan(group, Arity), out));
+        }
+        impl::sha256_many(jobs);
+        std::swap(level, parents);
     }
+    return next_sibling == proof.siblings.size() && level.front().second == root;
+}
+
+bool verify(std::span<const BytesSpan> leaves, const MultiProof& proof, const Hash& root)
+{
+    return verify<2>(leaves, proof, root);
+}
 
-    const size_t padded_leaf_count = nodes_.size() / 2;
-    std::vector<Hash> siblings;
-    siblings.reserve(std::bit_width(padded_leaf_count));
+template <size_t Arity>
+BasicBatchVerifier<Arity>::BasicBatchVerifier(const Hash& root)
+    : root_(root)
+{
+    known_.emplace(1, root);
+}
 
-    for (size_t t = leaf_index + padded_leaf_count; t > 1; t >>= 1) {
-        siblings.push_back(nodes_[t ^ 1]);
+template <size_t Arity>
+bool BasicBatchVerifier<Arity>::verify(BytesSpan leaf, const BasicProof<Arity>& proof)
+{
+    return walk(hash_leaf(leaf), proof);
+}
+
+template <size_t Arity>
+void BasicBatchVerifier<Arity>::verify(std::span<const BytesSpan> leaves, std::span<const BasicProof<Arity>> proofs, std::span<bool> results)
+{
+    if (leaves.size() != proofs.size() || leaves.size() != results.size()) {
+        throw std::invalid_argument("BatchVerifier: leaves, proofs and results must match in size");
     }
 
-    return Proof { .leaf_index = leaf_index, .siblings = std::move(siblings) };
+    std::array<Hash, JOB_CHUNK> hashes;
+    std::array<impl::Sha256Job, JOB_CHUNK> jobs {};
+    for (size_t first = 0; first < leaves.size(); first += JOB_CHUNK) {
+        const size_t n = std::min(JOB_CHUNK, leaves.size() - first);
+        for (size_t j = 0; j < n; ++j) {
+            jobs[j] = leaf_job(leaves[first + j], hashes[j]);
+        }
+        impl::sha256_many(std::span(jobs).first(n));
+        for (size_t j = 0; j < n; ++j) {
+            results[first + j] = walk(hashes[j], proofs[first + j]);
+        }
+    }
 }
 
-Tree::const_reference Tree::leaf(size_type leaf_index) const
+template <size_t Arity>
+size_t BasicBatchVerifier<Arity>::cached_nodes() const
 {
-    return leaves_.at(leaf_index); // .at() provides bounds checking
+    std::lock_guard lock(mutex_);
+    return known_.size();
 }
 
+template <size_t Arity>
+bool BasicBatchVerifier<Arity>::walk(const Hash& leaf_hash, const BasicProof<Arity>& proof)
+{
+    if (proof.siblings.size() % (Arity - 1) != 0) {
+        return false;
+    }
+    const size_t depth = proof.siblings.size() / (Arity - 1);
+    const size_t padded_leaf_count = padded_count<Arity>(depth);
+    if (padded_leaf_count == 0 || proof.leaf_index >= padded_leaf_count) {
+        return false;
+    }
+
+    // Nodes computed or received on the way up, remembered only on success
+    std::vector<std::pair<size_t, Hash>> seen;
+    seen.reserve(depth * Arity);
+
+    Hash acc = leaf_hash;
+    std::array<Hash, Arity> children;
+    size_t width = padded_leaf_count;
+    size_t j = proof.leaf_index;
+    for (size_t level = 0;; ++level, width /= Arity, j /= Arity) {
+        {
+            std::lock_guard lock(mutex_);
+            if (auto it = known_.find(width + j); it != known_.end()) {
+                if (it->second != acc) {
+                    return false;
+                }
+                known_.insert(seen.begin(), seen.end());
+                return true;
+            }
+        }
+        // The root (width 1) is always known, so the path ends above
+        const auto sib = proof.siblings.begin() + (level * (Arity - 1));
+        const size_t pos = j % Arity;
+        std::copy_n(sib, pos, children.begin());
+        children[pos] = acc;
+        std::copy_n(sib + pos, Arity - 1 - pos, children.begin() + pos + 1);
+        for (size_t c = 0; c < Arity; ++c) {
+            seen.emplace_back(width + (j - pos) + c, children[c]);
+        }
+        acc = hash_children(children);
+    }
+}
+
+template class BasicTree<2>;
+template class BasicTree<4>;
+template class BasicTree<8>;
+template class BasicTree<16>;
+
+template bool verify<2>(BytesSpan, const BasicProof<2>&, const Hash&) noexcept;
+template bool verify<4>(BytesSpan, const BasicProof<4>&, const Hash&) noexcept;
+template bool verify<8>(BytesSpan, const BasicProof<8>&, const Hash&) noexcept;
+template bool verify<16>(BytesSpan, const BasicProof<16>&, const Hash&) noexcept;
+
+template bool verify<2>(std::span<const BytesSpan>, const MultiProof&, const Hash&);
+template bool verify<4>(std::span<const BytesSpan>, const MultiProof&, const Hash&);
+template bool verify<8>(std::span<const BytesSpan>, const MultiProof&, const Hash&);
+template bool verify<16>(std::span<const BytesSpan>, const MultiProof&, const Hash&);
+
+template class BasicBatchVerifier<2>;
+template class BasicBatchVerifier<4>;
+template class BasicBatchVerifier<8>;
+template class BasicBatchVerifier<16>;
+
 } // namespace Honey::Crypto::MerkleTree
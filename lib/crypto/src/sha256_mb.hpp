@@ -0,0 +1,85 @@
+#pragma once
+
+#include "crypto/common.hpp"
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace Honey::Crypto::impl {
+
+/**
+ * @brief One SHA-256 message given as the concatenation of up to three parts.
+ *
+ * Merkle nodes are hashed as prefix || data or prefix || left || right, so the
+ * parts let callers skip building the concatenation. `digest` receives 32 bytes.
+ */
+struct Sha256Job {
+    std::array<BytesSpan, 3> parts;
+    Byte* digest;
+};
+
+/// Compression kernels, from the portable fallback to the widest SIMD one.
+enum class Sha256Kernel : std::uint8_t {
+    Portable, ///< scalar C++, one message at a time
+    ShaNi, ///< x86 SHA extensions, one message at a time
+    Sse4x, ///< 4 messages per SSE2 vector
+    Avx2x8, ///< 8 messages per AVX2 vector
+    Avx512x16, ///< 16 messages per AVX-512 vector
+};
+
+[[nodiscard]] bool sha256_kernel_supported(Sha256Kernel kernel) noexcept;
+
+/// Kernel picked at first use from the running CPU's features.
+[[nodiscard]] Sha256Kernel sha256_default_kernel() noexcept;
+
+[[nodiscard]] std::string_view sha256_kernel_name(Sha256Kernel kernel) noexcept;
+
+/// Hashes a single message with the best single-lane kernel.
+void sha256_one(const Sha256Job& job) noexcept;
+
+/**
+ * @brief Hashes independent messages several lanes at a time.
+ *
+ * Jobs are grouped by block count so lanes of a SIMD batch finish together;
+ * leftovers that cannot fill a batch go through the best single-lane kernel.
+ */
+void sha256_many(std::span<const Sha256Job> jobs);
+
+/// Same, but every job goes through `kernel`, which must be supported.
+void sha256_many(std::span<const Sha256Job> jobs, Sha256Kernel kernel);
+
+/**
+ * @brief Several messages hashed incrementally, side by side.
+ *
+ * Each `update` appends one chunk to every message. While all chunks have
+ * the same size, as with column stripes of erasure-coded shards, the
+ * messages stay block-aligned with each other and go through the SIMD
+ * kernel together; otherwise each message is hashed on its own.
+ */
+class Sha256Lanes {
+public:
+    explicit Sha256Lanes(std::size_t count, Sha256Kernel kernel = sha256_default_kernel());
+
+    [[nodiscard]] std::size_t size() const noexcept { return lanes_.size(); }
+
+    /// Appends `chunks[i]` to message i; `chunks` must have `size()` entries.
+    void update(std::span<const BytesSpan> chunks);
+
+    /// Writes the digest of message i to `digests[i]`; no updates afterwards.
+    void finish(std::span<Byte* const> digests);
+
+private:
+    struct Lane {
+        std::array<std::uint32_t, 8> state;
+        std::array<std::uint8_t, 64> buffer;
+        std::size_t buffered;
+        std::uint64_t total;
+    };
+
+    std::vector<Lane> lanes_;
+    Sha256Kernel kernel_;
+};
+
+} // namespace Honey::Crypto::impl
@@ -0,0 +1,102 @@
+#include "crypto/shard_commitment.hpp"
+#include "sha256_mb.hpp"
+
+#include <array>
+#include <optional>
+
+namespace Honey::Crypto {
+
+namespace {
+    constexpr std::array<Byte, 1> LEAF_PREFIX { Byte { 0x00 } };
+} // namespace
+
+auto encode_and_commit(const ErasureCode::Context& ctx, BytesSpan payload)
+    -> std::expected<CommittedShards, std::error_code>
+{
+    using MerkleTree::Hash;
+
+    // Lanes are created once the shard count is known, i.e. with the first
+    // stripe; each starts with the leaf prefix.
+    std::optional<impl::Sha256Lanes> lanes;
+    std::vector<BytesSpan> chunks;
+
+    auto arena = ErasureCode::encode_streaming(ctx, payload,
+        [&](const ErasureCode::ShardArena& shards, std::size_t offset, std::size_t len) {
+            const auto n = static_cast<std::size_t>(shards.size());
+            if (!lanes) {
+                lanes.emplace(n);
+                chunks.assign(n, BytesSpan(LEAF_PREFIX));
+                lanes->update(chunks);
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                chunks[i] = shards[static_cast<int>(i)].subspan(offset, len);
+            }
+            lanes->update(chunks);
+        });
+    if (!arena) {
+        return std::unexpected(arena.error());
+    }
+
+    const auto n = static_cast<std::size_t>(arena->size());
+    std::vector<Hash> leaf_hashes(n);
+    std::vector<Byte*> digests(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        digests[i] = leaf_hashes[i].data();
+    }
+    lanes->finish(digests);
+
+    const std::size_t block_size = arena->block_size();
+    const BytesSpan rows((*arena)[0].data(), ((n - 1) * arena->stride()) + block_size);
+
+    CommittedShards out {
+        .shards = *arena,
+        .tree = MerkleTree::Tree::build(rows, block_size, arena->stride(), arena->storage(), leaf_hashes),
+        .proofs = {},
+    };
+    out.proofs.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        auto proof = out.tree.prove(i);
+        if (!proof) {
+            return std::unexpected(proof.error());
+        }
+        out.proofs.push_back(std::move(*proof));
+    }
+    return out;
+}
+
+auto decode_and_recommit(const ErasureCode::Context& ctx, std::span<const ErasureCode::ShardView> shards,
+    const MerkleTree::Hash& root, MutableBytesSpan output)
+    -> std::expected<std::size_t, std::error_code>
+{
+    using MerkleTree::Hash;
+
+    const auto n = static_cast<std::size_t>(ctx.N());
+    impl::Sha256Lanes lanes(n);
+    std::vector<BytesSpan> chunks(n, BytesSpan(LEAF_PREFIX));
+    lanes.update(chunks);
+
+    auto len = ErasureCode::reencode_streaming(ctx, shards, output,
+        [&](std::span<const BytesSpan> all, std::size_t offset, std::size_t stripe_len) {
+            for (std::size_t i = 0; i < n; ++i) {
+                chunks[i] = all[i].subspan(offset, stripe_len);
+            }
+            lanes.update(chunks);
+        });
+    if (!len) {
+        return std::unexpected(len.error());
+    }
+
+    std::vector<Hash> leaf_hashes(n);
+    std::vector<Byte*> digests(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        digests[i] = leaf_hashes[i].data();
+    }
+    lanes.finish(digests);
+
+    if (MerkleTree::Tree::root_of(leaf_hashes) != root) {
+        return std::unexpected(std::make_error_code(std::errc::bad_message));
+    }
+    return *len;
+}
+
+} // namespace Honey::Crypto
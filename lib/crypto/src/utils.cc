@@ -1,33 +1,37 @@
 #include "threshold/utils.hpp"
 #include "crypto/common.hpp"
+#include "sha256_mb.hpp"
 #include <cstddef>
 #include <cstring>
+#include <memory>
 #include <openssl/evp.h>
-#include <openssl/opensslv.h>
 #include <openssl/rand.h>
 #include <stdexcept>
 #include <string>
 
 namespace Honey::Crypto::Utils {
 
+// No per-call algorithm fetch or context allocation, which matters for the
+// short messages hashed on the ECDSA and hashG paths. The SHA-NI kernel is
+// the fastest; without it OpenSSL's assembly beats the portable kernel
+// several times over.
 Hash256 sha256(BytesSpan data)
 {
     Hash256 hash;
-    size_t len = 0;
-
-#if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    EVP_Q_digest(
-        nullptr, "SHA256", nullptr,
-        u8ptr(data), data.size(),
-        u8ptr(hash.data()), &len);
-#else
-    // 兼容旧版本或通用写法
-    EvpMdCtxPtr ctx(EVP_MD_CTX_new());
-    EVP_DigestInit_ex(ctx.get(), EVP_sha256(), nullptr);
-    EVP_DigestUpdate(ctx.get(), u8ptr(data), data.size());
-    EVP_DigestFinal_ex(ctx.get(), u8ptr(hash.data()), &len);
-#endif
+    static const bool sha_ni = impl::sha256_kernel_supported(impl::Sha256Kernel::ShaNi);
+    if (sha_ni) {
+        impl::sha256_one({ .parts = { data, {}, {} }, .digest = hash.data() });
+        return hash;
+    }
 
+    static EVP_MD* const md = EVP_MD_fetch(nullptr, "SHA256", nullptr);
+    thread_local const std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)> ctx(EVP_MD_CTX_new(), &EVP_MD_CTX_free);
+    if (md == nullptr || !ctx
+        || EVP_DigestInit_ex(ctx.get(), md, nullptr) != 1
+        || EVP_DigestUpdate(ctx.get(), u8ptr(data), data.size()) != 1
+        || EVP_DigestFinal_ex(ctx.get(), u8ptr(hash.data()), nullptr) != 1) {
+        throw std::runtime_error("SHA-256 failed");
+    }
     return hash;
 }
 
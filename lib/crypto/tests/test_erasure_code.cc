@@ -1,7 +1,13 @@
 #include "crypto/erasure_code.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
 #include <gtest/gtest.h>
 #include <map>
+#include <numeric>
 #include <random>
+#include <thread>
 #include <vector>
 
 namespace Honey::Crypto::ErasureCode {
@@ -150,6 +156,418 @@ TEST_F(ErasureCodeTest, Errors)
 
     // 3. 无效参数 (K > N)
     EXPECT_FALSE(Context::create(5, 3).has_value());
+
+    // 4. 超出 GF(2^8) 的分片数
+    EXPECT_FALSE(Context::create(100, 256).has_value());
+}
+
+// 测试 6: 连续分片内存
+TEST_F(ErasureCodeTest, ArenaMatchesShardVectors)
+{
+    for (size_t len : { 0, 1, 3, 100, 4096 }) {
+        auto data = random_bytes(len);
+
+        auto arena_res = encode_to_arena(*ctx, data);
+        ASSERT_TRUE(arena_res.has_value());
+        const ShardArena& arena = *arena_res;
+        auto shards = *encode(*ctx, data);
+
+        ASSERT_EQ(arena.size(), N);
+        std::map<int, std::vector<Byte>> received;
+        for (int i = 0; i < N; ++i) {
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(arena[i].data()) % SHARD_ALIGNMENT, 0U);
+            EXPECT_TRUE(std::ranges::equal(arena[i], shards[i])) << "shard " << i << " len " << len;
+            if (i >= N - K)
+                received[i] = std::vector<Byte>(arena[i].begin(), arena[i].end());
+        }
+
+        auto decoded = decode(*ctx, received);
+        ASSERT_TRUE(decoded.has_value());
+        expect_bytes_eq(data, *decoded);
+    }
+}
+
+// 测试 7: 视图在 arena 析构后仍由 storage 持有
+TEST_F(ErasureCodeTest, ArenaViewsOutliveArena)
+{
+    auto data = random_bytes(256);
+    std::shared_ptr<const void> storage;
+    std::vector<BytesSpan> views;
+    {
+        auto arena = *encode_to_arena(*ctx, data);
+        storage = arena.storage();
+        views = arena.views();
+    }
+
+    auto shards = *encode(*ctx, data);
+    ASSERT_EQ(views.size(), shards.size());
+    for (size_t i = 0; i < views.size(); ++i) {
+        EXPECT_TRUE(std::ranges::equal(views[i], shards[i]));
+    }
+}
+
+// 测试 8: 解码表缓存
+TEST_F(ErasureCodeTest, DecodeTablesAreCached)
+{
+    auto data = random_bytes(512);
+    auto shards = *encode(*ctx, data);
+
+    auto decode_from = [&](const Context& c, std::initializer_list<int> indexes) {
+        std::map<int, std::vector<Byte>> received;
+        for (int i : indexes)
+            received[i] = shards[i];
+        auto decoded = decode(c, received);
+        ASSERT_TRUE(decoded.has_value());
+        expect_bytes_eq(data, *decoded);
+    };
+
+    // Fast path 不需要解码表
+    decode_from(*ctx, { 0, 1, 2, 3 });
+    EXPECT_EQ(ctx->cached_decode_tables(), 0);
+
+    decode_from(*ctx, { 1, 3, 5, 9 });
+    EXPECT_EQ(ctx->cached_decode_tables(), 1);
+
+    // 相同的分片集合命中缓存
+    decode_from(*ctx, { 1, 3, 5, 9 });
+    EXPECT_EQ(ctx->cached_decode_tables(), 1);
+
+    decode_from(*ctx, { 0, 2, 6, 7 });
+    EXPECT_EQ(ctx->cached_decode_tables(), 2);
+
+    // 容量限制与禁用缓存
+    auto small = *Context::create(K, N, 1);
+    decode_from(small, { 1, 3, 5, 9 });
+    decode_from(small, { 0, 2, 6, 7 });
+    decode_from(small, { 1, 3, 5, 9 });
+    EXPECT_EQ(small.cached_decode_tables(), 1);
+
+    auto uncached = *Context::create(K, N, 0);
+    decode_from(uncached, { 1, 3, 5, 9 });
+    EXPECT_EQ(uncached.cached_decode_tables(), 0);
+}
+
+// 测试 9: 解码到调用方缓冲区
+TEST_F(ErasureCodeTest, DecodeIntoCallerBuffer)
+{
+    auto data = random_bytes(1000);
+    auto shards = *encode(*ctx, data);
+    size_t block_size = shards[0].size();
+
+    auto views_of = [&](std::initializer_list<int> indexes) {
+        std::vector<ShardView> views;
+        for (int i : indexes)
+            views.push_back({ .index = i, .data = shards[i] });
+        return views;
+    };
+
+    // 乱序、重复的分片均可接受
+    for (auto indexes : { std::initializer_list<int> { 3, 1, 0, 2 },
+             std::initializer_list<int> { 9, 2, 7, 2, 5 } }) {
+        std::vector<Byte> output(max_decoded_size(*ctx, block_size));
+        auto len = decode(*ctx, views_of(indexes), output);
+        ASSERT_TRUE(len.has_value());
+        output.resize(*len);
+        expect_bytes_eq(data, output);
+    }
+
+    // 输出恰好容纳原始数据
+    std::vector<Byte> exact(data.size());
+    ASSERT_TRUE(decode(*ctx, views_of({ 4, 5, 6, 7 }), exact).has_value());
+    expect_bytes_eq(data, exact);
+
+    // 输出过短
+    std::vector<Byte> short_output(data.size() - 1);
+    auto res = decode(*ctx, views_of({ 0, 1, 2, 3 }), short_output);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), std::errc::no_buffer_space);
+
+    // 去重后不足 K 个分片，或索引越界
+    std::vector<Byte> output(max_decoded_size(*ctx, block_size));
+    res = decode(*ctx, views_of({ 0, 1, 1, 2 }), output);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), std::errc::invalid_argument);
+
+    std::vector<ShardView> bad_index = views_of({ 0, 1, 2 });
+    bad_index.push_back({ .index = N, .data = shards[3] });
+    res = decode(*ctx, bad_index, output);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), std::errc::invalid_argument);
+}
+
+// 测试 10: 任意 K 个分片组合（缺失 0..K 个数据分片）均可恢复
+TEST_F(ErasureCodeTest, RecoverFromEveryShardSubset)
+{
+    auto data = random_bytes(333);
+    auto shards = *encode(*ctx, data);
+    std::vector<Byte> output(max_decoded_size(*ctx, shards[0].size()));
+
+    for (unsigned mask = 0; mask < (1U << N); ++mask) {
+        if (std::popcount(mask) != K)
+            continue;
+
+        std::vector<ShardView> views;
+        for (int i = 0; i < N; ++i) {
+            if ((mask & (1U << i)) != 0)
+                views.push_back({ .index = i, .data = shards[i] });
+        }
+
+        auto len = decode(*ctx, views, output);
+        ASSERT_TRUE(len.has_value()) << "mask " << mask;
+        ASSERT_EQ(*len, data.size());
+        EXPECT_TRUE(std::equal(data.begin(), data.end(), output.begin())) << "mask " << mask;
+    }
+}
+
+// 测试 11: 条带并行编解码与串行结果逐字节一致
+TEST_F(ErasureCodeTest, ParallelMatchesSerial)
+{
+    auto data = random_bytes(2 << 20);
+
+    std::size_t max_stripes = 0;
+    ParallelFor parallel = [&](std::size_t count, const std::function<void(std::size_t)>& task) {
+        max_stripes = std::max(max_stripes, count);
+        std::atomic<std::size_t> next { 0 };
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&] {
+                for (std::size_t i = next++; i < count; i = next++)
+                    task(i);
+            });
+        }
+        for (auto& w : workers)
+            w.join();
+    };
+
+    auto serial = *encode(*ctx, data);
+    auto striped = *encode(*ctx, data, parallel);
+    EXPECT_GT(max_stripes, 1U);
+    ASSERT_EQ(serial.size(), striped.size());
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(serial[i] == striped[i]) << "shard " << i;
+    }
+
+    std::map<int, std::vector<Byte>> received;
+    for (int i : { 1, 5, 8, 9 })
+        received[i] = striped[i];
+    auto decoded = decode(*ctx, received, parallel);
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_TRUE(*decoded == data);
+}
+
+// 测试 12: GF(2^16) FFT 后端，任意 K 个分片组合均可恢复（含 K > m 时按组累加的编码）
+TEST_F(ErasureCodeTest, Gf16RecoverFromEveryShardSubset)
+{
+    for (auto [k, n] : { std::pair { 4, 10 }, std::pair { 7, 10 }, std::pair { 1, 3 } }) {
+        auto gf16 = Context::create(k, n, Backend::Gf16Fft);
+        ASSERT_TRUE(gf16.has_value());
+        EXPECT_EQ(gf16->backend(), Backend::Gf16Fft);
+
+        auto data = random_bytes(333);
+        auto shards = *encode(*gf16, data);
+        ASSERT_EQ(shards.size(), n);
+        ASSERT_EQ(shards[0].size() % 2, 0U);
+        std::vector<Byte> output(max_decoded_size(*gf16, shards[0].size()));
+
+        for (unsigned mask = 0; mask < (1U << n); ++mask) {
+            if (std::popcount(mask) != k)
+                continue;
+
+            std::vector<ShardView> views;
+            for (int i = 0; i < n; ++i) {
+                if ((mask & (1U << i)) != 0)
+                    views.push_back({ .index = i, .data = shards[i] });
+            }
+
+            auto len = decode(*gf16, views, output);
+            ASSERT_TRUE(len.has_value()) << "K=" << k << " mask " << mask;
+            ASSERT_EQ(*len, data.size());
+            EXPECT_TRUE(std::equal(data.begin(), data.end(), output.begin()))
+                << "K=" << k << " mask " << mask;
+        }
+    }
+}
+
+// 测试 13: GF(2^16) 支持超过 255 个分片
+TEST_F(ErasureCodeTest, Gf16WideCluster)
+{
+    const int wide_n = 1024;
+    const int f = (wide_n - 1) / 3;
+    const int wide_k = wide_n - (2 * f);
+
+    EXPECT_FALSE(Context::create(wide_k, wide_n).has_value());
+    EXPECT_FALSE(Context::create(0, 4, Backend::Gf16Fft).has_value());
+    EXPECT_FALSE(Context::create(4, 4, Backend::Gf16Fft).has_value());
+    EXPECT_FALSE(Context::create(40000, 70000, Backend::Gf16Fft).has_value());
+
+    auto gf16 = *Context::create(wide_k, wide_n, Backend::Gf16Fft);
+    auto data = random_bytes(100000);
+    auto shards = *encode(gf16, data);
+    ASSERT_EQ(shards.size(), wide_n);
+
+    // 丢弃 f 个数据分片与部分校验分片，恰好保留 K 个
+    std::mt19937 rng(7);
+    std::vector<int> indexes(wide_n);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::shuffle(indexes.begin() + f, indexes.end(), rng);
+
+    std::map<int, std::vector<Byte>> received;
+    for (int i = f; i < f + wide_k; ++i)
+        received[indexes[i]] = shards[indexes[i]];
+
+    auto decoded = decode(gf16, received);
+    ASSERT_TRUE(decoded.has_value());
+    expect_bytes_eq(data, *decoded);
+
+    // 奇数长度的分片不是合法的 GF(2^16) 符号序列
+    std::vector<ShardView> odd;
+    for (const auto& [idx, shard] : received)
+        odd.push_back({ .index = idx, .data = BytesSpan(shard).first(shard.size() - 1) });
+    std::vector<Byte> output(decoded->size());
+    auto res = decode(gf16, odd, output);
+    ASSERT_FALSE(res.has_value());
+    EXPECT_EQ(res.error(), std::errc::invalid_argument);
+}
+
+// 测试 14: 批量编码与逐个编码结果一致，且共享同一块内存
+TEST_F(ErasureCodeTest, EncodeBatchMatchesSingle)
+{
+    auto gf16 = *Context::create(K, N, Backend::Gf16Fft);
+
+    for (const Context* c : { ctx.get(), &gf16 }) {
+        std::vector<std::vector<Byte>> payloads;
+        for (size_t len : { 0, 1, 100, 4096, 777 }) {
+            payloads.push_back(random_bytes(len));
+        }
+        std::vector<BytesSpan> spans(payloads.begin(), payloads.end());
+
+        auto batch = encode_batch(*c, spans);
+        ASSERT_TRUE(batch.has_value());
+        ASSERT_EQ(batch->size(), payloads.size());
+
+        for (size_t j = 0; j < payloads.size(); ++j) {
+            const ShardArena& arena = (*batch)[j];
+            auto single = *encode_to_arena(*c, payloads[j]);
+            ASSERT_EQ(arena.size(), N);
+            ASSERT_EQ(arena.block_size(), single.block_size());
+            EXPECT_EQ(arena.storage(), (*batch)[0].storage());
+
+            for (int i = 0; i < N; ++i) {
+                EXPECT_EQ(reinterpret_cast<std::uintptr_t>(arena[i].data()) % SHARD_ALIGNMENT, 0U);
+                EXPECT_TRUE(std::ranges::equal(arena[i], single[i])) << "payload " << j << " shard " << i;
+            }
+
+            std::map<int, std::vector<Byte>> received;
+            for (int i = N - K; i < N; ++i)
+                received[i] = std::vector<Byte>(arena[i].begin(), arena[i].end());
+            auto decoded = decode(*c, received);
+            ASSERT_TRUE(decoded.has_value());
+            expect_bytes_eq(payloads[j], *decoded);
+        }
+    }
+
+    EXPECT_TRUE(encode_batch(*ctx, {}).value().empty());
+}
+
+// 测试 15: 流式编码与 encode_to_arena 逐字节一致，条带按升序无重叠地覆盖整个分片
+TEST_F(ErasureCodeTest, StreamingMatchesArena)
+{
+    auto gf16 = *Context::create(K, N, Backend::Gf16Fft);
+
+    for (const Context* c : { ctx.get(), &gf16 }) {
+        for (size_t len : { 0, 100, 3 << 20 }) {
+            auto data = random_bytes(len);
+
+            std::size_t covered = 0;
+            std::size_t stripes = 0;
+            auto streamed = encode_streaming(*c, data, [&](const ShardArena& arena, std::size_t offset, std::size_t n) {
+                EXPECT_EQ(offset, covered);
+                EXPECT_GT(n, 0U);
+                covered += n;
+                ++stripes;
+            });
+            ASSERT_TRUE(streamed.has_value());
+
+            auto arena = *encode_to_arena(*c, data);
+            ASSERT_EQ(streamed->block_size(), arena.block_size());
+            EXPECT_EQ(covered, arena.block_size());
+            if (len > (1 << 20)) {
+                EXPECT_GT(stripes, 1U);
+            }
+            for (int i = 0; i < N; ++i) {
+                EXPECT_TRUE(std::ranges::equal((*streamed)[i], arena[i])) << "len " << len << " shard " << i;
+            }
+        }
+    }
+}
+
+// 重新编码：sink 看到的 N 个分片应与编码结果逐字节一致，载荷与 decode 相同
+TEST_F(ErasureCodeTest, ReencodeRegeneratesEveryShard)
+{
+    auto gf16 = *Context::create(K, N, Backend::Gf16Fft);
+    const std::vector<std::vector<int>> subsets {
+        { 0, 1, 2, 3 }, // 数据分片齐全
+        { 1, 3, 4, 8 }, // 缺失数据分片
+        { 6, 7, 8, 9 }, // 只有校验分片
+        { 0, 2, 5, 6, 7, 9 }, // 多于 K 个
+    };
+
+    for (const Context* c : { ctx.get(), &gf16 }) {
+        for (size_t len : { 100, 3 << 20 }) {
+            auto data = random_bytes(len);
+            auto arena = *encode_to_arena(*c, data);
+
+            for (const auto& subset : subsets) {
+                std::vector<ShardView> views;
+                for (int i : subset) {
+                    views.push_back({ .index = i, .data = arena[i] });
+                }
+
+                std::vector<std::vector<Byte>> seen(N, std::vector<Byte>(arena.block_size()));
+                std::size_t covered = 0;
+                std::vector<Byte> output(max_decoded_size(*c, arena.block_size()));
+                auto decoded = reencode_streaming(*c, views, output,
+                    [&](std::span<const BytesSpan> shards, std::size_t offset, std::size_t n) {
+                        ASSERT_EQ(shards.size(), static_cast<size_t>(N));
+                        EXPECT_EQ(offset, covered);
+                        covered += n;
+                        for (int i = 0; i < N; ++i) {
+                            std::ranges::copy(shards[i].subspan(offset, n), seen[i].begin() + static_cast<std::ptrdiff_t>(offset));
+                        }
+                    });
+                ASSERT_TRUE(decoded.has_value());
+                output.resize(*decoded);
+                expect_bytes_eq(output, data);
+                EXPECT_EQ(covered, arena.block_size());
+                for (int i = 0; i < N; ++i) {
+                    EXPECT_TRUE(std::ranges::equal(seen[i], arena[i])) << "len " << len << " shard " << i;
+                }
+            }
+        }
+    }
+}
+
+// 参与解码之外收到的分片不被信任，同样重新生成
+TEST_F(ErasureCodeTest, ReencodeIgnoresUnusedShards)
+{
+    auto data = random_bytes(1000);
+    auto arena = *encode_to_arena(*ctx, data);
+    std::vector<Byte> forged(arena[9].begin(), arena[9].end());
+    forged[0] ^= Byte { 1 };
+
+    std::vector<ShardView> views;
+    for (int i : { 0, 1, 2, 3 }) {
+        views.push_back({ .index = i, .data = arena[i] });
+    }
+    views.push_back({ .index = 9, .data = forged });
+
+    std::vector<Byte> output(max_decoded_size(*ctx, arena.block_size()));
+    bool regenerated = false;
+    auto decoded = reencode_streaming(*ctx, views, output, [&](std::span<const BytesSpan> shards, std::size_t, std::size_t) {
+        regenerated = std::ranges::equal(shards[9], arena[9]);
+    });
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_TRUE(regenerated);
 }
 
 } // namespace Honey::Crypto::ErasureCode
@@ -1,4 +1,10 @@
 #include "crypto/merkle_tree.hpp"
+#include "crypto/erasure_code.hpp"
+#include <algorithm>
+#include <bit>
+#include <memory>
+#include <numeric>
+#include <type_traits>
 #include <gtest/gtest.h>
 
 namespace Honey::Crypto::MerkleTree {
@@ -14,6 +20,25 @@ namespace {
         return res;
     }
 
+    Hash from_hex(std::string_view hex)
+    {
+        Hash h {};
+        for (size_t i = 0; i < h.size(); ++i) {
+            h[i] = static_cast<Byte>(std::stoi(std::string(hex.substr(2 * i, 2)), nullptr, 16));
+        }
+        return h;
+    }
+
+    std::vector<std::string> numbered(size_t n)
+    {
+        std::vector<std::string> strings;
+        strings.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            strings.push_back("leaf_" + std::to_string(i));
+        }
+        return strings;
+    }
+
     auto create_leaves(const std::vector<std::string>& strings)
     {
         std::vector<std::vector<Byte>> leaves;
@@ -162,6 +187,270 @@ TEST_F(MerkleTreeTest, DetectsProofTampering)
 //     EXPECT_NE(malicious_leaf_h, internal_h) << "Domain separation is broken!";
 // }
 
+TEST_F(MerkleTreeTest, BuildFromBorrowedViews)
+{
+    auto leaves = create_leaves({ "d1", "d2", "d3", "d4", "d5" });
+    auto storage = std::make_shared<std::vector<std::vector<Byte>>>(leaves);
+    std::vector<BytesSpan> views(storage->begin(), storage->end());
+
+    Tree owned = Tree::build(std::move(leaves));
+    Tree borrowed = Tree::build(views, storage);
+
+    EXPECT_EQ(borrowed.root(), owned.root());
+    ASSERT_EQ(borrowed.size(), views.size());
+    for (size_t i = 0; i < borrowed.size(); ++i) {
+        // Leaves are views of the caller's buffers, not copies
+        EXPECT_EQ(borrowed.leaf(i).data(), views[i].data());
+        EXPECT_TRUE(verify(borrowed.leaf(i), borrowed.prove(i).value(), borrowed.root()));
+    }
+}
+
+TEST_F(MerkleTreeTest, BuildFromStripedBuffer)
+{
+    auto leaves = create_leaves({ "d1", "d2", "d3", "d4", "d5" });
+    auto buffer = std::make_shared<std::vector<Byte>>();
+    for (const auto& leaf : leaves) {
+        buffer->insert(buffer->end(), leaf.begin(), leaf.end());
+    }
+
+    Tree owned = Tree::build(std::move(leaves));
+    Tree striped = Tree::build(*buffer, 2, buffer);
+
+    EXPECT_EQ(striped.root(), owned.root());
+    ASSERT_EQ(striped.size(), owned.size());
+    for (size_t i = 0; i < striped.size(); ++i) {
+        EXPECT_EQ(striped.leaf(i).data(), buffer->data() + (2 * i));
+        EXPECT_TRUE(verify(striped.leaf(i), striped.prove(i).value(), striped.root()));
+    }
+    EXPECT_TRUE(std::ranges::equal(striped, owned, std::ranges::equal));
+}
+
+TEST_F(MerkleTreeTest, BuildFromShardArena)
+{
+    // Odd block size, so the arena stride carries alignment padding
+    auto ctx = ErasureCode::Context::create(4, 7).value();
+    std::vector<Byte> payload(1001, Byte { 0x5a });
+    auto arena = ErasureCode::encode_to_arena(ctx, payload).value();
+    ASSERT_GT(arena.stride(), arena.block_size());
+
+    const auto views = arena.views();
+    const size_t span_bytes = ((arena.size() - 1) * arena.stride()) + arena.block_size();
+    Tree striped = Tree::build(BytesSpan(arena[0].data(), span_bytes), arena.block_size(), arena.stride(), arena.storage());
+    Tree borrowed = Tree::build(views, arena.storage());
+
+    EXPECT_EQ(striped.root(), borrowed.root());
+    ASSERT_EQ(striped.size(), views.size());
+    for (size_t i = 0; i < striped.size(); ++i) {
+        EXPECT_EQ(striped.leaf(i).data(), views[i].data());
+    }
+}
+
+TEST_F(MerkleTreeTest, StripedBufferRejectsBadGeometry)
+{
+    std::vector<Byte> buffer(10);
+    EXPECT_THROW((void)Tree::build(buffer, 3, nullptr), std::invalid_argument);
+    EXPECT_THROW((void)Tree::build(buffer, 0, nullptr), std::invalid_argument);
+    EXPECT_THROW((void)Tree::build(buffer, 4, 2, nullptr), std::invalid_argument);
+    EXPECT_TRUE(Tree::build(BytesSpan {}, 4, nullptr).empty());
+
+    Tree tree = Tree::build(buffer, 4, 6, nullptr);
+    EXPECT_EQ(tree.size(), 2);
+    EXPECT_THROW((void)tree.leaf(2), std::out_of_range);
+}
+
+TEST_F(MerkleTreeTest, BuildFromPrecomputedLeafHashes)
+{
+    std::vector<Byte> buffer(5 * 8);
+    for (size_t i = 0; i < buffer.size(); ++i) {
+        buffer[i] = static_cast<Byte>(i);
+    }
+    const BytesSpan stripes = BytesSpan(buffer).first((4 * 8) + 6);
+
+    // A one-leaf tree's root is the hash of its leaf
+    std::vector<Hash> leaf_hashes;
+    for (size_t i = 0; i < 5; ++i) {
+        leaf_hashes.push_back(Tree::build(stripes.subspan(i * 8, 6), 6, nullptr).root());
+    }
+
+    Tree expected = Tree::build(stripes, 6, 8, nullptr);
+    Tree tree = Tree::build(stripes, 6, 8, nullptr, leaf_hashes);
+    EXPECT_EQ(tree.root(), expected.root());
+    EXPECT_EQ(tree.size(), 5);
+    EXPECT_TRUE(std::ranges::equal(tree.leaf(3), expected.leaf(3)));
+    EXPECT_TRUE(verify(tree.leaf(4), tree.prove(4).value(), expected.root()));
+
+    EXPECT_THROW((void)Tree::build(stripes, 6, 8, nullptr, std::span(leaf_hashes).first(4)), std::invalid_argument);
+}
+
+TEST_F(MerkleTreeTest, BatchVerifierAcceptsEveryLeaf)
+{
+    for (size_t n : { 1, 2, 5, 100 }) {
+        std::vector<std::string> strings;
+        for (size_t i = 0; i < n; ++i) {
+            strings.push_back("leaf_" + std::to_string(i));
+        }
+        Tree tree = Tree::build(create_leaves(strings));
+
+        BatchVerifier verifier(tree.root());
+        for (size_t i = 0; i < n; ++i) {
+            EXPECT_TRUE(verifier.verify(tree.leaf(i), tree.prove(i).value())) << "n=" << n << " leaf " << i;
+        }
+        // At most every node of the padded tree
+        EXPECT_LE(verifier.cached_nodes(), 2 * std::bit_ceil(n) - 1);
+    }
+}
+
+TEST_F(MerkleTreeTest, BatchVerifierRejectsWithoutCaching)
+{
+    Tree tree = Tree::build(create_leaves({ "d1", "d2", "d3", "d4", "d5" }));
+    BatchVerifier verifier(tree.root());
+
+    auto fake = to_bytes("fake");
+    EXPECT_FALSE(verifier.verify(fake, tree.prove(1).value()));
+
+    auto bad_proof = tree.prove(2).value();
+    bad_proof.siblings[0][0] ^= Byte { 0x01 };
+    EXPECT_FALSE(verifier.verify(tree.leaf(2), bad_proof));
+
+    auto out_of_depth = tree.prove(2).value();
+    out_of_depth.leaf_index += 8;
+    EXPECT_FALSE(verifier.verify(tree.leaf(2), out_of_depth));
+
+    EXPECT_EQ(verifier.cached_nodes(), 1); // only the root
+
+    // Once leaf 0's path is known, a fake leaf 1 clashes with the cached sibling
+    EXPECT_TRUE(verifier.verify(tree.leaf(0), tree.prove(0).value()));
+    EXPECT_FALSE(verifier.verify(fake, tree.prove(1).value()));
+    EXPECT_TRUE(verifier.verify(tree.leaf(1), tree.prove(1).value()));
+
+    Hash other_root = tree.root();
+    other_root[0] ^= Byte { 0x01 };
+    BatchVerifier wrong(other_root);
+    EXPECT_FALSE(wrong.verify(tree.leaf(0), tree.prove(0).value()));
+}
+
+TEST_F(MerkleTreeTest, BatchVerifierBulkMatchesSingle)
+{
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < 70; ++i) {
+        strings.push_back("leaf_" + std::to_string(i));
+    }
+    Tree tree = Tree::build(create_leaves(strings));
+    auto fake = to_bytes("fake");
+
+    std::vector<BytesSpan> leaves;
+    std::vector<Proof> proofs;
+    for (size_t i = 0; i < tree.size(); ++i) {
+        leaves.push_back(i % 7 == 3 ? BytesSpan(fake) : tree.leaf(i));
+        proofs.push_back(tree.prove(i).value());
+    }
+
+    auto flags = std::make_unique<bool[]>(leaves.size());
+    BatchVerifier verifier(tree.root());
+    verifier.verify(leaves, proofs, std::span(flags.get(), leaves.size()));
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        EXPECT_EQ(flags[i], verify(leaves[i], proofs[i], tree.root())) << "leaf " << i;
+    }
+
+    EXPECT_THROW(verifier.verify(leaves, std::span(proofs).first(3), std::span(flags.get(), leaves.size())), std::invalid_argument);
+}
+
+TEST_F(MerkleTreeTest, MultiProofCoversEverySubset)
+{
+    for (size_t n : { 1, 5, 8 }) {
+        std::vector<std::string> strings;
+        for (size_t i = 0; i < n; ++i) {
+            strings.push_back("leaf_" + std::to_string(i));
+        }
+        Tree tree = Tree::build(create_leaves(strings));
+
+        for (size_t mask = 1; mask < (size_t { 1 } << n); ++mask) {
+            std::vector<size_t> indices;
+            std::vector<BytesSpan> leaves;
+            for (size_t i = 0; i < n; ++i) {
+                if ((mask >> i) & 1) {
+                    indices.push_back(i);
+                    leaves.push_back(tree.leaf(i));
+                }
+            }
+            auto proof = tree.prove(std::span<const size_t>(indices)).value();
+            EXPECT_EQ(proof.leaf_indices, indices);
+            EXPECT_TRUE(verify(leaves, proof, tree.root())) << "n=" << n << " mask=" << mask;
+        }
+    }
+}
+
+TEST_F(MerkleTreeTest, MultiProofSharesSiblings)
+{
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < 16; ++i) {
+        strings.push_back("leaf_" + std::to_string(i));
+    }
+    Tree tree = Tree::build(create_leaves(strings));
+
+    // Leaves 0 and 1 are siblings: only the three upper siblings remain
+    std::vector<size_t> pair = { 1, 0, 1 };
+    auto pair_proof = tree.prove(std::span<const size_t>(pair)).value();
+    EXPECT_EQ(pair_proof.leaf_indices, (std::vector<size_t> { 0, 1 }));
+    EXPECT_EQ(pair_proof.siblings.size(), 3);
+
+    // Every leaf: nothing to prove beyond the leaves themselves
+    std::vector<size_t> all(16);
+    std::iota(all.begin(), all.end(), 0);
+    EXPECT_TRUE(tree.prove(std::span<const size_t>(all)).value().siblings.empty());
+
+    // Two leaves in opposite halves share nothing but the root
+    std::vector<size_t> far = { 0, 15 };
+    EXPECT_EQ(tree.prove(std::span<const size_t>(far)).value().siblings.size(), 6);
+
+    std::vector<size_t> out_of_range = { 3, 16 };
+    EXPECT_FALSE(tree.prove(std::span<const size_t>(out_of_range)).has_value());
+    EXPECT_FALSE(tree.prove(std::span<const size_t>()).has_value());
+}
+
+TEST_F(MerkleTreeTest, MultiProofDetectsTampering)
+{
+    Tree tree = Tree::build(create_leaves({ "d1", "d2", "d3", "d4", "d5" }));
+    std::vector<size_t> indices = { 0, 3, 4 };
+    auto proof = tree.prove(std::span<const size_t>(indices)).value();
+    std::vector<BytesSpan> leaves = { tree.leaf(0), tree.leaf(3), tree.leaf(4) };
+    ASSERT_TRUE(verify(leaves, proof, tree.root()));
+
+    auto fake = to_bytes("fake");
+    auto forged = leaves;
+    forged[1] = fake;
+    EXPECT_FALSE(verify(forged, proof, tree.root()));
+
+    std::vector<BytesSpan> swapped = { tree.leaf(3), tree.leaf(0), tree.leaf(4) };
+    EXPECT_FALSE(verify(swapped, proof, tree.root()));
+
+    auto bad_sibling = proof;
+    bad_sibling.siblings.back()[0] ^= Byte { 0x01 };
+    EXPECT_FALSE(verify(leaves, bad_sibling, tree.root()));
+
+    auto extra_sibling = proof;
+    extra_sibling.siblings.push_back(Hash {});
+    EXPECT_FALSE(verify(leaves, extra_sibling, tree.root()));
+
+    auto missing_sibling = proof;
+    missing_sibling.siblings.pop_back();
+    EXPECT_FALSE(verify(leaves, missing_sibling, tree.root()));
+
+    auto unsorted = proof;
+    std::swap(unsorted.leaf_indices[0], unsorted.leaf_indices[1]);
+    EXPECT_FALSE(verify(swapped, unsorted, tree.root()));
+
+    EXPECT_FALSE(verify(std::span(leaves).first(2), proof, tree.root()));
+}
+
+TEST_F(MerkleTreeTest, KnownRoot)
+{
+    // SHA-256 over 0x00 || leaf and 0x01 || left || right, padded with the empty leaf
+    Tree tree = Tree::build(create_leaves({ "a", "b", "c" }));
+
+    EXPECT_EQ(tree.root(), from_hex("da4b92343516e8268e41de5a54d7b2eb9443e98c31e76a8ba2b4abefa6773fc6"));
+}
+
 TEST_F(MerkleTreeTest, LargeTree)
 {
     const size_t N = 100;
@@ -183,4 +472,106 @@ TEST_F(MerkleTreeTest, LargeTree)
     }
 }
 
+template <typename T>
+class WideMerkleTreeTest : public ::testing::Test { };
+
+using Arities = ::testing::Types<BasicTree<4>, BasicTree<8>, BasicTree<16>>;
+TYPED_TEST_SUITE(WideMerkleTreeTest, Arities);
+
+TYPED_TEST(WideMerkleTreeTest, ProvesEveryLeaf)
+{
+    constexpr size_t A = TypeParam::arity;
+    for (size_t n : { 1, 2, 5, 17, 100 }) {
+        auto tree = TypeParam::build(create_leaves(numbered(n)));
+        ASSERT_EQ(tree.size(), n);
+
+        size_t depth = 0;
+        for (size_t p = 1; p < n; p *= A) {
+            ++depth;
+        }
+        BasicBatchVerifier<A> batch(tree.root());
+        for (size_t i = 0; i < n; ++i) {
+            auto proof = tree.prove(i).value();
+            EXPECT_EQ(proof.siblings.size(), depth * (A - 1));
+            EXPECT_TRUE(verify<A>(tree.leaf(i), proof, tree.root())) << "n=" << n << " leaf " << i;
+            EXPECT_TRUE(batch.verify(tree.leaf(i), proof)) << "n=" << n << " leaf " << i;
+        }
+    }
+}
+
+TYPED_TEST(WideMerkleTreeTest, DetectsTampering)
+{
+    constexpr size_t A = TypeParam::arity;
+    auto tree = TypeParam::build(create_leaves(numbered(40)));
+    auto proof = tree.prove(21).value();
+    auto fake = to_bytes("fake");
+    EXPECT_FALSE(verify<A>(fake, proof, tree.root()));
+
+    auto bad_sibling = proof;
+    bad_sibling.siblings.back()[0] ^= Byte { 0x01 };
+    EXPECT_FALSE(verify<A>(tree.leaf(21), bad_sibling, tree.root()));
+
+    auto short_level = proof;
+    short_level.siblings.pop_back();
+    EXPECT_FALSE(verify<A>(tree.leaf(21), short_level, tree.root()));
+
+    // A wide proof cannot pass for a binary one; unqualified verify deduces
+    // its arity
+    static_assert(!std::is_convertible_v<decltype(proof), Proof>);
+    EXPECT_TRUE(verify(tree.leaf(21), proof, tree.root()));
+
+    BasicBatchVerifier<A> batch(tree.root());
+    EXPECT_FALSE(batch.verify(tree.leaf(21), bad_sibling));
+    EXPECT_EQ(batch.cached_nodes(), 1);
+}
+
+TYPED_TEST(WideMerkleTreeTest, MultiProof)
+{
+    constexpr size_t A = TypeParam::arity;
+    auto tree = TypeParam::build(create_leaves(numbered(37)));
+
+    for (const std::vector<size_t>& indices : std::vector<std::vector<size_t>> { { 0 }, { 0, 1 }, { 3, 17, 18, 36 }, { 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 } }) {
+        auto proof = tree.prove(std::span<const size_t>(indices)).value();
+        std::vector<BytesSpan> leaves;
+        for (size_t i : indices) {
+            leaves.push_back(tree.leaf(i));
+        }
+        EXPECT_TRUE(verify<A>(leaves, proof, tree.root()));
+
+        size_t single_siblings = 0;
+        for (size_t i : indices) {
+            single_siblings += tree.prove(i).value().siblings.size();
+        }
+        EXPECT_LE(proof.siblings.size(), single_siblings);
+
+        auto fake = to_bytes("fake");
+        leaves.back() = fake;
+        EXPECT_FALSE(verify<A>(leaves, proof, tree.root()));
+    }
+}
+
+TEST(WideMerkleTree, KnownRoot)
+{
+    // Five leaves padded to 16; four 4-ary nodes under the root
+    auto tree = BasicTree<4>::build(create_leaves({ "a", "b", "c", "d", "e" }));
+    EXPECT_EQ(tree.root(), from_hex("9c0f1db3868acf90bb1e7afea6a7c8213c786d07c2383859ae8b7b47353f0f4f"));
+}
+
+TEST(WideMerkleTree, ProofCapacityCoversMaxLeaves)
+{
+    EXPECT_EQ(MAX_PROOF_SIBLINGS<2>, 10);
+    EXPECT_EQ(MAX_PROOF_SIBLINGS<16>, 45);
+    // A binary proof has room for its own paths only
+    EXPECT_LT(sizeof(Proof), sizeof(BasicProof<16>));
+    EXPECT_LE(sizeof(Proof), sizeof(size_t) * 2 + (MAX_PROOF_SIBLINGS<2> * sizeof(Hash)));
+
+    // 16-ary over 4097 leaves needs four levels of 15 siblings
+    auto tree = BasicTree<16>::build(create_leaves(numbered(4097)));
+    auto too_long = tree.prove(7);
+    ASSERT_FALSE(too_long.has_value());
+    EXPECT_EQ(too_long.error(), std::make_error_code(std::errc::value_too_large));
+    const std::array<size_t, 1> index { 7 };
+    EXPECT_TRUE(tree.prove(std::span<const size_t>(index)).has_value());
+}
+
 } // namespace Honey::Crypto::MerkleTree
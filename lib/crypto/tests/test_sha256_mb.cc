@@ -0,0 +1,197 @@
+#include "sha256_mb.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <openssl/evp.h>
+#include <random>
+#include <vector>
+
+namespace Honey::Crypto::impl {
+
+namespace {
+
+    constexpr Sha256Kernel ALL_KERNELS[] = {
+        Sha256Kernel::Portable,
+        Sha256Kernel::ShaNi,
+        Sha256Kernel::Sse4x,
+        Sha256Kernel::Avx2x8,
+        Sha256Kernel::Avx512x16,
+    };
+
+    std::vector<Byte> random_bytes(size_t len, uint32_t seed)
+    {
+        std::vector<Byte> res(len);
+        std::mt19937 rng(seed);
+        for (auto& b : res) {
+            b = static_cast<Byte>(rng());
+        }
+        return res;
+    }
+
+    // Reference digest of the concatenated parts, from OpenSSL
+    Hash256 reference(const Sha256Job& job)
+    {
+        std::vector<Byte> msg;
+        for (auto part : job.parts) {
+            msg.insert(msg.end(), part.begin(), part.end());
+        }
+        Hash256 hash {};
+        EVP_Digest(msg.data(), msg.size(), u8ptr(hash.data()), nullptr, EVP_sha256(), nullptr);
+        return hash;
+    }
+
+    // Lengths straddling the 55/56/64-byte padding boundaries
+    std::vector<size_t> boundary_lengths()
+    {
+        std::vector<size_t> lens;
+        for (size_t base : { 0, 64, 128, 1024 }) {
+            for (size_t delta : { 0, 1, 54, 55, 56, 57, 63 }) {
+                lens.push_back(base + delta);
+            }
+        }
+        return lens;
+    }
+}
+
+class Sha256ManyTest : public ::testing::TestWithParam<Sha256Kernel> {
+protected:
+    void SetUp() override
+    {
+        if (!sha256_kernel_supported(GetParam())) {
+            GTEST_SKIP() << sha256_kernel_name(GetParam()) << " not supported on this CPU";
+        }
+    }
+};
+
+TEST_P(Sha256ManyTest, SplitPartsMatchReference)
+{
+    const auto lens = boundary_lengths();
+    const Byte prefix { 0x01 };
+
+    std::vector<std::vector<Byte>> data;
+    std::vector<Hash256> digests(lens.size() * 3);
+    std::vector<Sha256Job> jobs;
+    for (size_t i = 0; i < lens.size(); ++i) {
+        data.push_back(random_bytes(lens[i], static_cast<uint32_t>(i)));
+    }
+    for (size_t i = 0; i < lens.size(); ++i) {
+        const BytesSpan d = data[i];
+        const size_t half = d.size() / 2;
+        jobs.push_back({ .parts = { d, {}, {} }, .digest = digests[3 * i].data() });
+        jobs.push_back({ .parts = { BytesSpan(&prefix, 1), d, {} }, .digest = digests[(3 * i) + 1].data() });
+        jobs.push_back({ .parts = { BytesSpan(&prefix, 1), d.first(half), d.subspan(half) }, .digest = digests[(3 * i) + 2].data() });
+    }
+
+    sha256_many(jobs, GetParam());
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        EXPECT_EQ(digests[i], reference(jobs[i])) << "job " << i;
+    }
+}
+
+TEST_P(Sha256ManyTest, EveryLaneCount)
+{
+    // Partial batches must not disturb the lanes that are filled
+    for (size_t count = 1; count <= 40; ++count) {
+        std::vector<std::vector<Byte>> data;
+        std::vector<Hash256> digests(count);
+        std::vector<Sha256Job> jobs;
+        for (size_t i = 0; i < count; ++i) {
+            data.push_back(random_bytes(100 + (i * 37), static_cast<uint32_t>(count + i)));
+        }
+        for (size_t i = 0; i < count; ++i) {
+            jobs.push_back({ .parts = { data[i], {}, {} }, .digest = digests[i].data() });
+        }
+
+        sha256_many(jobs, GetParam());
+
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(digests[i], reference(jobs[i])) << "count " << count << " job " << i;
+        }
+    }
+}
+
+TEST_P(Sha256ManyTest, LanesMatchReference)
+{
+    // Equal chunks keep the lanes in lockstep; the ragged round forces the
+    // per-lane path and the rounds after it must still line up.
+    for (size_t count : { 1, 3, 16, 21 }) {
+        std::vector<std::vector<Byte>> messages(count);
+        Sha256Lanes lanes(count, GetParam());
+        uint32_t seed = 0;
+        auto round = [&](auto chunk_len) {
+            std::vector<std::vector<Byte>> chunks;
+            for (size_t i = 0; i < count; ++i) {
+                chunks.push_back(random_bytes(chunk_len(i), seed++));
+                messages[i].insert(messages[i].end(), chunks.back().begin(), chunks.back().end());
+            }
+            std::vector<BytesSpan> spans(chunks.begin(), chunks.end());
+            lanes.update(spans);
+        };
+        for (size_t len : { 1, 63, 64, 65, 1000 }) {
+            round([&](size_t) { return len; });
+        }
+        round([](size_t i) { return 10 + i; });
+        round([](size_t) { return size_t { 130 }; });
+
+        std::vector<Hash256> digests(count);
+        std::vector<Byte*> outputs;
+        for (auto& d : digests) {
+            outputs.push_back(d.data());
+        }
+        lanes.finish(outputs);
+
+        for (size_t i = 0; i < count; ++i) {
+            EXPECT_EQ(digests[i], reference({ .parts = { messages[i], {}, {} }, .digest = nullptr }))
+                << "count " << count << " lane " << i;
+        }
+    }
+
+    Sha256Lanes lanes(2, GetParam());
+    std::vector<BytesSpan> one(1);
+    EXPECT_THROW(lanes.update(one), std::invalid_argument);
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, Sha256ManyTest, ::testing::ValuesIn(ALL_KERNELS),
+    [](const auto& info) {
+        std::string name(sha256_kernel_name(info.param));
+        std::ranges::replace(name, '-', '_');
+        return name;
+    });
+
+TEST(Sha256ManyDefault, MatchesReference)
+{
+    std::vector<std::vector<Byte>> data;
+    std::vector<Hash256> digests(37);
+    std::vector<Sha256Job> jobs;
+    for (size_t i = 0; i < digests.size(); ++i) {
+        data.push_back(random_bytes(i * 29, static_cast<uint32_t>(i)));
+    }
+    for (size_t i = 0; i < digests.size(); ++i) {
+        jobs.push_back({ .parts = { data[i], {}, {} }, .digest = digests[i].data() });
+    }
+
+    sha256_many(jobs);
+
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        EXPECT_EQ(digests[i], reference(jobs[i])) << "job " << i;
+    }
+
+    Hash256 single {};
+    sha256_one({ .parts = { data[5], {}, {} }, .digest = single.data() });
+    EXPECT_EQ(single, digests[5]);
+}
+
+TEST(Sha256ManyDefault, UtilsSha256KnownAnswer)
+{
+    // FIPS 180-2 test vector
+    const Hash256 hash = Utils::sha256(as_span("abc"));
+    const Hash256 expected {
+        Byte { 0xba }, Byte { 0x78 }, Byte { 0x16 }, Byte { 0xbf }, Byte { 0x8f }, Byte { 0x01 }, Byte { 0xcf }, Byte { 0xea },
+        Byte { 0x41 }, Byte { 0x41 }, Byte { 0x40 }, Byte { 0xde }, Byte { 0x5d }, Byte { 0xae }, Byte { 0x22 }, Byte { 0x23 },
+        Byte { 0xb0 }, Byte { 0x03 }, Byte { 0x61 }, Byte { 0xa3 }, Byte { 0x96 }, Byte { 0x17 }, Byte { 0x7a }, Byte { 0x9c },
+        Byte { 0xb4 }, Byte { 0x10 }, Byte { 0xff }, Byte { 0x61 }, Byte { 0xf2 }, Byte { 0x00 }, Byte { 0x15 }, Byte { 0xad },
+    };
+    EXPECT_EQ(hash, expected);
+}
+
+} // namespace Honey::Crypto::impl
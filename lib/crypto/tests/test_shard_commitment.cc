@@ -0,0 +1,148 @@
+#include "crypto/shard_commitment.hpp"
+#include <algorithm>
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+namespace Honey::Crypto {
+
+namespace {
+
+    std::vector<Byte> random_bytes(size_t len, uint32_t seed)
+    {
+        std::vector<Byte> res(len);
+        std::mt19937 rng(seed);
+        for (auto& b : res) {
+            b = static_cast<Byte>(rng());
+        }
+        return res;
+    }
+
+    // What the leader did before: encode, then build and prove separately
+    void expect_matches_separate_passes(const ErasureCode::Context& ctx, BytesSpan payload)
+    {
+        auto committed = encode_and_commit(ctx, payload);
+        ASSERT_TRUE(committed.has_value());
+
+        auto arena = *ErasureCode::encode_to_arena(ctx, payload);
+        const auto views = arena.views();
+        MerkleTree::Tree tree = MerkleTree::Tree::build(views, nullptr);
+
+        ASSERT_EQ(committed->shards.size(), arena.size());
+        ASSERT_EQ(committed->tree.size(), views.size());
+        ASSERT_EQ(committed->proofs.size(), views.size());
+        EXPECT_EQ(committed->tree.root(), tree.root());
+        for (size_t i = 0; i < views.size(); ++i) {
+            const BytesSpan shard = committed->shards[static_cast<int>(i)];
+            EXPECT_TRUE(std::ranges::equal(shard, views[i])) << "shard " << i;
+            EXPECT_TRUE(std::ranges::equal(committed->tree.leaf(i), shard)) << "leaf " << i;
+            EXPECT_EQ(committed->proofs[i].leaf_index, i);
+            EXPECT_EQ(committed->proofs[i].siblings, tree.prove(i)->siblings) << "proof " << i;
+            EXPECT_TRUE(MerkleTree::verify(shard, committed->proofs[i], tree.root())) << "proof " << i;
+        }
+    }
+}
+
+TEST(ShardCommitmentTest, MatchesSeparatePasses)
+{
+    auto ctx = *ErasureCode::Context::create(4, 10);
+    // The last size spans several encoder stripes
+    for (size_t len : { 0, 1, 100, 4096, 777, 3 << 20 }) {
+        SCOPED_TRACE(len);
+        expect_matches_separate_passes(ctx, random_bytes(len, static_cast<uint32_t>(len)));
+    }
+}
+
+TEST(ShardCommitmentTest, Gf16Backend)
+{
+    auto ctx = *ErasureCode::Context::create(22, 64, ErasureCode::Backend::Gf16Fft);
+    for (size_t len : { 1, 5000, 1 << 20 }) {
+        SCOPED_TRACE(len);
+        expect_matches_separate_passes(ctx, random_bytes(len, static_cast<uint32_t>(len)));
+    }
+}
+
+TEST(ShardCommitmentTest, OutlivesArenaHandle)
+{
+    auto ctx = *ErasureCode::Context::create(2, 4);
+    auto payload = random_bytes(300, 7);
+
+    MerkleTree::Tree tree;
+    std::vector<MerkleTree::Proof> proofs;
+    {
+        auto committed = *encode_and_commit(ctx, payload);
+        tree = std::move(committed.tree);
+        proofs = std::move(committed.proofs);
+    }
+    // The tree keeps the shard storage alive
+    for (size_t i = 0; i < tree.size(); ++i) {
+        EXPECT_TRUE(MerkleTree::verify(tree.leaf(i), proofs[i], tree.root()));
+    }
+}
+
+namespace {
+    std::expected<std::vector<Byte>, std::error_code> recommit(const ErasureCode::Context& ctx,
+        const ErasureCode::ShardArena& arena, std::initializer_list<int> indices, const MerkleTree::Hash& root)
+    {
+        std::vector<ErasureCode::ShardView> views;
+        for (int i : indices) {
+            views.push_back({ .index = i, .data = arena[i] });
+        }
+        std::vector<Byte> output(ErasureCode::max_decoded_size(ctx, arena.block_size()));
+        auto len = decode_and_recommit(ctx, views, root, output);
+        if (!len) {
+            return std::unexpected(len.error());
+        }
+        output.resize(*len);
+        return output;
+    }
+} // namespace
+
+TEST(ShardCommitmentTest, RecommitAcceptsHonestDispersal)
+{
+    auto gf8 = *ErasureCode::Context::create(4, 10);
+    auto gf16 = *ErasureCode::Context::create(4, 10, ErasureCode::Backend::Gf16Fft);
+    for (const auto* ctx : { &gf8, &gf16 }) {
+        for (size_t len : { 0, 777, 3 << 20 }) {
+            SCOPED_TRACE(len);
+            const auto payload = random_bytes(len, static_cast<uint32_t>(len));
+            const auto committed = *encode_and_commit(*ctx, payload);
+            const auto root = committed.tree.root();
+
+            EXPECT_EQ(recommit(*ctx, committed.shards, { 0, 1, 2, 3 }, root), payload);
+            EXPECT_EQ(recommit(*ctx, committed.shards, { 2, 5, 7, 9 }, root), payload);
+            EXPECT_EQ(recommit(*ctx, committed.shards, { 1, 3, 4, 6, 8 }, root), payload);
+        }
+    }
+}
+
+TEST(ShardCommitmentTest, RecommitRejectsInconsistentDispersal)
+{
+    auto ctx = *ErasureCode::Context::create(4, 10);
+    const auto payload = random_bytes(5000, 3);
+    auto arena = *ErasureCode::encode_to_arena(ctx, payload);
+
+    // A leader commits to shards that are not one codeword: parity 9 is forged
+    std::vector<std::vector<Byte>> leaves;
+    for (BytesSpan shard : arena.views()) {
+        leaves.emplace_back(shard.begin(), shard.end());
+    }
+    leaves[9][17] ^= Byte { 0x5A };
+    const auto root = MerkleTree::Tree::build(std::vector(leaves)).root();
+
+    const auto mismatch = std::make_error_code(std::errc::bad_message);
+    // Each shard below is a valid leaf under `root`, yet none reveal it alone
+    EXPECT_EQ(recommit(ctx, arena, { 0, 1, 2, 3 }, root).error(), mismatch);
+    EXPECT_EQ(recommit(ctx, arena, { 4, 5, 6, 7 }, root).error(), mismatch);
+
+    // Holding the forged shard does not help: it is not used to decode
+    std::vector<ErasureCode::ShardView> views;
+    for (int i : { 0, 1, 2, 3 }) {
+        views.push_back({ .index = i, .data = arena[i] });
+    }
+    views.push_back({ .index = 9, .data = leaves[9] });
+    std::vector<Byte> output(ErasureCode::max_decoded_size(ctx, arena.block_size()));
+    EXPECT_EQ(decode_and_recommit(ctx, views, root, output).error(), mismatch);
+}
+
+} // namespace Honey::Crypto